@@ -45,6 +45,35 @@ setup() {
   assert_output "bounding box [-3, 7] x [-2, 8]"
 }
 
+@test "kover bounding-box runs correctly on a scene with 1 sector antenna" {
+  run kover bounding-box < "$examples_dir"/1s.scene
+  assert_success
+  assert_output "bounding box [0, 5] x [-3, 3]"
+}
+
+@test "kover bounding-box runs correctly on a scene with mixed antennas" {
+  run kover bounding-box < "$examples_dir"/1b1a1s.scene
+  assert_success
+  assert_output "bounding box [-5, 6] x [-2, 4]"
+}
+
+@test "kover bounding-box runs correctly on a stream of scenes" {
+  run kover bounding-box < "$examples_dir"/stream.scene
+  assert_success
+  assert_line --index 0 "bounding box [-1, 1] x [-1, 1]"
+  assert_line --index 1 "bounding box [-3, 7] x [-2, 8]"
+  assert_line --index 2 "undefined (empty scene)"
+}
+
+@test "kover bounding-box ignores lines of blanks between and after the scenes of a stream" {
+  run kover bounding-box < "$examples_dir"/stream_blank_lines.scene
+  assert_success
+  assert_output - <<EOT
+bounding box [-1, 1] x [-1, 1]
+bounding box [-1, 1] x [-1, 1]
+EOT
+}
+
 # Wrong lines
 # -----------
 
@@ -66,6 +95,12 @@ setup() {
   assert_output "error: last line must be exactly 'end scene'"
 }
 
+@test "kover bounding-box reports an error in a later scene of a stream" {
+  run kover bounding-box < "$examples_dir"/stream_overlapping.invalid
+  [ "$status" -eq 1 ]
+  assert_line --index 1 "error: buildings b1 and b2 are overlapping"
+}
+
 # Wrong buildings
 # ---------------
 
@@ -0,0 +1,98 @@
+setup() {
+  load 'bats-support/load'
+  load 'bats-assert/load'
+  root_dir="$(cd "$( dirname "$BATS_TEST_FILENAME" )/.." >/dev/null 2>&1 && pwd)"
+  PATH="$root_dir/bin:$PATH"
+  examples_dir="$root_dir/examples"
+}
+
+# Normal usage
+# ------------
+
+@test "kover cover runs correctly on an empty scene" {
+  run kover cover < "$examples_dir"/empty.scene
+  assert_success
+  assert_output "minimum cover with 0 antennas"
+}
+
+@test "kover cover runs correctly on a scene with 1 building and 1 antenna" {
+  run kover cover < "$examples_dir"/1b1a.scene
+  assert_success
+  assert_output - <<EOT
+minimum cover with 1 antenna
+  antenna a1 at 2 3 with range 5
+EOT
+}
+
+@test "kover cover finds a smaller cover than the greedy choice" {
+  run kover cover < "$examples_dir"/6b4a.scene
+  assert_success
+  assert_output - <<EOT
+minimum cover with 2 antennas
+  antenna a1 at 4 0 with range 6
+  antenna a2 at 16 0 with range 6
+EOT
+}
+
+@test "kover cover takes the sectors of the antennas into account" {
+  run kover cover < "$examples_dir"/2b3s.scene
+  assert_success
+  assert_output - <<EOT
+minimum cover with 1 antenna
+  antenna s3 at 0 -1 with range 10, azimuth 0 and beamwidth 300
+EOT
+}
+
+@test "kover cover reports a building without any covering antenna" {
+  run kover cover < "$examples_dir"/1b.scene
+  assert_success
+  assert_output "no cover (building b1 is not covered by any antenna)"
+}
+
+@test "kover cover does not cover a building crossing the blind cone of an antenna" {
+  run kover cover < "$examples_dir"/1b1s_blind_cone.scene
+  assert_success
+  assert_output "no cover (building b1 is not covered by any antenna)"
+}
+
+@test "kover cover --max-nodes reports a cover found within the budget as not proven" {
+  run kover cover --max-nodes 1 < "$examples_dir"/6b4a.scene
+  assert_success
+  assert_output - <<EOT
+cover with 3 antennas (not proven minimum)
+  antenna a1 at 4 0 with range 6
+  antenna a2 at 16 0 with range 6
+  antenna a3 at 10 0 with range 8
+EOT
+}
+
+@test "kover cover falls back to a greedy cover on scenes too large for the exact search" {
+  awk 'BEGIN { print "begin scene"; for (i = 0; i < 12000; i++) { x = i % 100 * 10; y = int(i / 100) * 10; print "  building b" i " " x " " y " 1 1"; print "  antenna a" i " " x " " y " 2" }; print "end scene" }' \
+    > "$BATS_TEST_TMPDIR"/grid.scene
+  run kover cover < "$BATS_TEST_TMPDIR"/grid.scene
+  assert_success
+  assert_line --index 0 "cover with 12000 antennas (not proven minimum)"
+}
+
+@test "kover cover stops the exact search of a hard scene within its default budget" {
+  awk 'BEGIN { srand(1); print "begin scene"; for (i = 0; i < 500; i++) print "  building b" i " " i % 25 * 10 " " int(i / 25) * 10 " 2 2"; for (i = 0; i < 500; ) { x = int(rand() * 250); y = int(rand() * 200); if (!((x, y) in seen)) { seen[x, y] = 1; print "  antenna a" i " " x " " y " " 15 + int(rand() * 31); i++ } }; print "end scene" }' \
+    > "$BATS_TEST_TMPDIR"/random.scene
+  run timeout 20 kover cover < "$BATS_TEST_TMPDIR"/random.scene
+  assert_success
+  assert_line --index 0 --regexp '^(minimum )?cover with [0-9]+ antennas'
+}
+
+# Wrong usage
+# -----------
+
+@test "kover cover --max-nodes reports an error with an invalid budget" {
+  run kover cover --max-nodes 0 < "$examples_dir"/6b4a.scene
+  assert_failure
+  assert_output "error: invalid value \"0\" for argument '--max-nodes'"
+}
+
+@test "kover cover --max-nodes reports an error without a budget" {
+  run kover cover --max-nodes < "$examples_dir"/6b4a.scene
+  assert_failure
+  assert_output "error: option '--max-nodes' requires an argument"
+}
@@ -0,0 +1,70 @@
+setup() {
+  load 'bats-support/load'
+  load 'bats-assert/load'
+  root_dir="$(cd "$( dirname "$BATS_TEST_FILENAME" )/.." >/dev/null 2>&1 && pwd)"
+  PATH="$root_dir/bin:$PATH"
+  examples_dir="$root_dir/examples"
+}
+
+# Normal usage
+# ------------
+
+@test "kover coverage runs correctly on an empty scene" {
+  run kover coverage < "$examples_dir"/empty.scene
+  assert_success
+  assert_output - <<EOT
+0 buildings covered by fewer than 1 antenna
+coverage histogram
+EOT
+}
+
+@test "kover coverage lists the uncovered buildings by default" {
+  run kover coverage < "$examples_dir"/1b.scene
+  assert_success
+  assert_output - <<EOT
+1 building covered by fewer than 1 antenna
+  building b1 covered by 0 antennas
+coverage histogram
+  0 antennas: 1 building
+EOT
+}
+
+@test "kover coverage --min lists the buildings covered by too few antennas" {
+  run kover coverage --min 2 < "$examples_dir"/6b4a.scene
+  assert_success
+  assert_output - <<EOT
+1 building covered by fewer than 2 antennas
+  building b6 covered by 1 antenna
+coverage histogram
+  0 antennas: 0 buildings
+  1 antenna: 1 building
+  2 antennas: 5 buildings
+EOT
+}
+
+@test "kover coverage takes the sectors of the antennas into account" {
+  run kover coverage --min 2 < "$examples_dir"/2b3s.scene
+  assert_success
+  assert_output - <<EOT
+0 buildings covered by fewer than 2 antennas
+coverage histogram
+  0 antennas: 0 buildings
+  1 antenna: 0 buildings
+  2 antennas: 2 buildings
+EOT
+}
+
+# Wrong usage
+# -----------
+
+@test "kover coverage --min reports an error without a value" {
+  run kover coverage --min < "$examples_dir"/6b4a.scene
+  [ "$status" -eq 1 ]
+  assert_output "error: option '--min' requires an argument"
+}
+
+@test "kover coverage --min reports an error with an invalid value" {
+  run kover coverage --min 0 < "$examples_dir"/6b4a.scene
+  [ "$status" -eq 1 ]
+  assert_output "error: invalid value \"0\" for argument '--min'"
+}
@@ -70,6 +70,15 @@ setup() {
   assert_line --index 2 "  antenna a1 at 2 3 with range 5"
 }
 
+@test "kover describe runs correctly on a scene with a sector antenna" {
+  run kover describe < "$examples_dir"/1b1a1s.scene
+  assert_success
+  assert_line --index 0 "A scene with 1 building and 2 antennas"
+  assert_line --index 1 "  building b1 at 0 0 with dimensions 1 1"
+  assert_line --index 2 "  antenna a1 at 4 0 with range 2"
+  assert_line --index 3 "  antenna s1 at -2 0 with range 4, azimuth 0 and beamwidth 90"
+}
+
 # Wrong lines
 # -----------
 
@@ -180,3 +189,15 @@ setup() {
   [ "$status" -eq 1 ]
   assert_output 'error: invalid positive integer "-1" (line #2)'
 }
+
+@test "kover describe reports an error when a sector antenna has an invalid azimuth" {
+  run kover describe < "$examples_dir"/1s_wrong_azimuth.invalid
+  [ "$status" -eq 1 ]
+  assert_output 'error: invalid azimuth "360" (line #2)'
+}
+
+@test "kover describe reports an error when a sector antenna has an invalid beamwidth" {
+  run kover describe < "$examples_dir"/1s_wrong_beamwidth.invalid
+  [ "$status" -eq 1 ]
+  assert_output 'error: invalid beamwidth "0" (line #2)'
+}
@@ -0,0 +1,101 @@
+setup() {
+  load 'bats-support/load'
+  load 'bats-assert/load'
+  root_dir="$(cd "$( dirname "$BATS_TEST_FILENAME" )/.." >/dev/null 2>&1 && pwd)"
+  PATH="$root_dir/bin:$PATH"
+  examples_dir="$root_dir/examples"
+}
+
+# Normal usage
+# ------------
+
+@test "kover hull runs correctly on an empty scene" {
+  run kover hull < "$examples_dir"/empty.scene
+  assert_success
+  assert_output "undefined (empty scene)"
+}
+
+@test "kover hull runs correctly on a scene with 1 building" {
+  run kover hull < "$examples_dir"/1b.scene
+  assert_success
+  assert_output - <<EOT
+convex hull with 4 vertices and area 4.00
+  vertex -1.00 -1.00
+  vertex 1.00 -1.00
+  vertex 1.00 1.00
+  vertex -1.00 1.00
+oriented bounding box with area 4.00 and angle 0.00
+  corner -1.00 -1.00
+  corner 1.00 -1.00
+  corner 1.00 1.00
+  corner -1.00 1.00
+minimum enclosing circle with center 0.00 0.00 and radius 1.41
+EOT
+}
+
+@test "kover hull finds a tighter box than the axis-aligned one" {
+  run kover hull < "$examples_dir"/2b.scene
+  assert_success
+  assert_output - <<EOT
+convex hull with 6 vertices and area 58.00
+  vertex -1.00 -1.00
+  vertex 1.00 -1.00
+  vertex 7.00 5.00
+  vertex 7.00 11.00
+  vertex 3.00 11.00
+  vertex -1.00 1.00
+oriented bounding box with area 83.86 and angle 68.20
+  corner 3.55 12.38
+  corner -1.69 -0.72
+  corner 3.83 -2.93
+  corner 9.07 10.17
+minimum enclosing circle with center 3.00 5.00 and radius 7.21
+EOT
+}
+
+@test "kover hull --sides replaces antenna disks by circumscribed polygons" {
+  run kover hull --sides 4 < "$examples_dir"/1a.scene
+  assert_success
+  assert_output - <<EOT
+convex hull with 4 vertices and area 4.00
+  vertex -1.41 0.00
+  vertex 0.00 -1.41
+  vertex 1.41 0.00
+  vertex 0.00 1.41
+oriented bounding box with area 4.00 and angle 45.00
+  corner 0.00 1.41
+  corner -1.41 0.00
+  corner 0.00 -1.41
+  corner 1.41 0.00
+minimum enclosing circle with center 0.00 0.00 and radius 1.41
+EOT
+}
+
+@test "kover hull encloses the sector of an antenna, not its whole disk" {
+  run kover hull --sides 3 < "$examples_dir"/1s.scene
+  assert_success
+  assert_output - <<EOT
+convex hull with 4 vertices and area 14.43
+  vertex 0.00 0.00
+  vertex 4.33 -2.50
+  vertex 5.77 0.00
+  vertex 4.33 2.50
+oriented bounding box with area 21.65 and angle 120.00
+  corner 6.50 -1.25
+  corner 4.33 2.50
+  corner 0.00 0.00
+  corner 2.17 -3.75
+minimum enclosing circle with center 2.89 0.00 and radius 2.89
+EOT
+  run kover bounding-box < "$examples_dir"/1s.scene
+  assert_output "bounding box [0, 5] x [-3, 3]"
+}
+
+# Wrong usage
+# -----------
+
+@test "kover hull --sides reports an error with too few sides" {
+  run kover hull --sides 2 < "$examples_dir"/1a.scene
+  [ "$status" -eq 1 ]
+  assert_output "error: invalid value \"2\" for argument '--sides'"
+}
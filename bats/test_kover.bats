@@ -19,3 +19,134 @@ setup() {
   [ "$status" -eq 1 ]
   assert_output "error: subcommand 'thing' is not recognized"
 }
+
+@test "kover with unrecognized option reports wrong usage" {
+  run kover --thing summarize
+  [ "$status" -eq 1 ]
+  assert_output "error: option '--thing' is not recognized"
+}
+
+# Statistics
+# ----------
+
+@test "kover --stats prints counters in Prometheus text format on stderr" {
+  run bash -c "kover --stats summarize < '$root_dir/examples/stream.scene' 2>&1 >/dev/null"
+  assert_success
+  assert_line "kover_scenes_total 3"
+  assert_line "kover_buildings_total 1"
+  assert_line "kover_antennas_total 2"
+  assert_line 'kover_scene_seconds_bucket{le="+Inf"} 3'
+}
+
+# Tracing
+# -------
+
+@test "kover --trace writes the internal phases as Chrome trace events" {
+  run kover --trace "$BATS_TEST_TMPDIR/trace.json" summarize < "$root_dir"/examples/stream.scene
+  assert_success
+  run cat "$BATS_TEST_TMPDIR/trace.json"
+  assert_line --index 0 '{"traceEvents":['
+  assert_line --regexp '^\{"name":"read_scene","ph":"B","ts":[0-9.]+,"pid":1,"tid":1\},$'
+  assert_line --regexp '^\{"name":"summarize","ph":"E","ts":[0-9.]+,"pid":1,"tid":1\},$'
+  assert_line --regexp '^\],"displayTimeUnit":"ms"\}$'
+}
+
+@test "kover --trace does not create the file when the arguments are invalid" {
+  run kover --trace "$BATS_TEST_TMPDIR/trace.json" unknown
+  [ "$status" -eq 1 ]
+  assert [ ! -e "$BATS_TEST_TMPDIR/trace.json" ]
+}
+
+@test "kover --trace without a file reports wrong usage" {
+  run kover --trace
+  [ "$status" -eq 1 ]
+  assert_output "error: option '--trace' requires an argument"
+}
+
+# Memory budget
+# -------------
+
+@test "kover --max-memory reports an error when the budget is exceeded" {
+  run kover --max-memory 1K summarize < "$root_dir"/examples/3b2a.scene
+  [ "$status" -eq 1 ]
+  assert_output "error: memory budget of 1024 bytes exceeded"
+}
+
+@test "kover --max-memory runs normally within the budget" {
+  run kover --max-memory 1M summarize < "$root_dir"/examples/3b2a.scene
+  assert_success
+  assert_output "A scene with 3 buildings and 2 antennas"
+}
+
+@test "kover --max-memory with an invalid size reports wrong usage" {
+  run kover --max-memory 12X summarize
+  [ "$status" -eq 1 ]
+  assert_output 'error: invalid memory size "12X"'
+}
+
+# Antenna spacing
+# ---------------
+
+@test "kover --min-antenna-spacing accepts antennas at the minimum spacing" {
+  run kover --min-antenna-spacing 5 summarize < "$root_dir"/examples/2b3a.scene
+  assert_success
+  assert_output "A scene with 2 buildings and 3 antennas"
+}
+
+@test "kover --min-antenna-spacing reports antennas closer than the spacing" {
+  run kover --min-antenna-spacing 6 summarize < "$root_dir"/examples/2b3a.scene
+  [ "$status" -eq 1 ]
+  assert_output "error: antennas a1 and a2 are closer than 6"
+}
+
+@test "kover --min-antenna-spacing with an invalid spacing reports wrong usage" {
+  run kover --min-antenna-spacing 0 summarize
+  [ "$status" -eq 1 ]
+  assert_output 'error: invalid antenna spacing "0"'
+}
+
+@test "kover --stats reports the peak memory of each subsystem" {
+  run bash -c "kover --stats describe < '$root_dir/examples/3b2a.scene' 2>&1 >/dev/null"
+  assert_success
+  assert_line --regexp '^kover_memory_peak_bytes\{subsystem="scene"\} [1-9][0-9]*$'
+  assert_line --regexp '^kover_memory_peak_bytes\{subsystem="output"\} [1-9][0-9]*$'
+  assert_line --regexp '^kover_memory_peak_bytes\{subsystem="total"\} [1-9][0-9]*$'
+}
+
+# Parallel scenes
+# ---------------
+
+@test "kover --jobs prints the results of a stream in the order of its scenes" {
+  run kover --jobs 2 summarize < "$root_dir"/examples/stream.scene
+  assert_success
+  assert_output - <<EOT
+A scene with 1 building
+A scene with 2 antennas
+An empty scene
+EOT
+}
+
+@test "kover --jobs gives the results and the counters of a sequential run" {
+  awk 'BEGIN { srand(4); for (s = 0; s < 50; s++) { print "begin scene"; for (i = 0; i < 40; i++) print "  building b" i " " i % 8 * 10 " " int(i / 8) * 10 " 2 2"; for (i = 0; i < 20; i++) print "  antenna a" i " " i * 4 " " int(rand() * 50) " " 5 + int(rand() * 20); print "end scene" } }' \
+    > "$BATS_TEST_TMPDIR"/stream.scene
+  kover --stats rooftops < "$BATS_TEST_TMPDIR"/stream.scene > "$BATS_TEST_TMPDIR"/sequential.out \
+    2> "$BATS_TEST_TMPDIR"/sequential.stats
+  run bash -c "kover --jobs 4 --stats rooftops < '$BATS_TEST_TMPDIR/stream.scene' 2> '$BATS_TEST_TMPDIR/parallel.stats'"
+  assert_success
+  assert_output "$(cat "$BATS_TEST_TMPDIR"/sequential.out)"
+  run grep -E '^kover_(scenes|lines|buildings|antennas|id_lookups|grid_lookups)_total ' "$BATS_TEST_TMPDIR"/parallel.stats
+  assert_output "$(grep -E '^kover_(scenes|lines|buildings|antennas|id_lookups|grid_lookups)_total ' "$BATS_TEST_TMPDIR"/sequential.stats)"
+  assert_line "kover_scenes_total 50"
+}
+
+@test "kover --jobs prints the results of the scenes before an invalid one" {
+  run bash -c "kover --jobs 2 bounding-box < '$root_dir/examples/stream_overlapping.invalid' 2>/dev/null"
+  [ "$status" -eq 1 ]
+  assert_output "bounding box [-1, 1] x [-1, 1]"
+}
+
+@test "kover --jobs with an invalid number reports wrong usage" {
+  run kover --jobs 65 summarize
+  [ "$status" -eq 1 ]
+  assert_output 'error: invalid number of jobs "65"'
+}
@@ -0,0 +1,81 @@
+setup() {
+  load 'bats-support/load'
+  load 'bats-assert/load'
+  root_dir="$(cd "$( dirname "$BATS_TEST_FILENAME" )/.." >/dev/null 2>&1 && pwd)"
+  PATH="$root_dir/bin:$PATH"
+  examples_dir="$root_dir/examples"
+}
+
+# Normal usage
+# ------------
+
+@test "kover nearest runs correctly on an empty scene" {
+  run kover nearest < "$examples_dir"/empty.scene
+  assert_success
+  assert_output - <<EOT
+nearest building of each building
+building distances histogram
+nearest antenna of each antenna
+antenna distances histogram
+EOT
+}
+
+@test "kover nearest reports a building without any other building" {
+  run kover nearest < "$examples_dir"/1b.scene
+  assert_success
+  assert_line --index 1 "  building b1: none"
+  assert_line --index 2 "building distances histogram"
+}
+
+@test "kover nearest runs correctly on a scene with buildings and antennas" {
+  run kover nearest < "$examples_dir"/2b3a.scene
+  assert_success
+  assert_output - <<EOT
+nearest building of each building
+  building b1: b2 at distance 10.00
+  building b2: b1 at distance 10.00
+building distances histogram
+  [0, 1): 0 buildings
+  [1, 2): 0 buildings
+  [2, 4): 0 buildings
+  [4, 8): 0 buildings
+  [8, 16): 2 buildings
+nearest antenna of each antenna
+  antenna a1: a2 at distance 5.00
+  antenna a2: a1 at distance 5.00
+  antenna a3: a1 at distance 5.00
+antenna distances histogram
+  [0, 1): 0 antennas
+  [1, 2): 0 antennas
+  [2, 4): 0 antennas
+  [4, 8): 3 antennas
+EOT
+}
+
+@test "kover nearest breaks ties by lowest identifier" {
+  run kover nearest < "$examples_dir"/6b4a.scene
+  assert_success
+  assert_line --index 3 "  building b3: b2 at distance 4.00"
+  assert_line --index 5 "  building b5: b4 at distance 4.00"
+}
+
+# Memory budget
+# -------------
+
+@test "kover nearest fails when the search exceeds --max-memory" {
+  # The budget lies halfway between the peaks of summarize, which only loads
+  # the scene, and nearest, which also builds its search tree
+  awk 'BEGIN { print "begin scene"; for (i = 0; i < 20000; i++) print "  antenna a" i " " 3 * i " 0 1"; print "end scene" }' \
+    > "$BATS_TEST_TMPDIR"/line.scene
+  for subcommand in summarize nearest; do
+    kover --stats "$subcommand" < "$BATS_TEST_TMPDIR"/line.scene \
+      > /dev/null 2> "$BATS_TEST_TMPDIR/$subcommand.stats"
+  done
+  local budget=$(cat "$BATS_TEST_TMPDIR"/summarize.stats "$BATS_TEST_TMPDIR"/nearest.stats |
+    awk '/^kover_memory_peak_bytes\{subsystem="total"\}/ { sum += $2 } END { print int(sum / 2) }')
+  run kover --max-memory "$budget" summarize < "$BATS_TEST_TMPDIR"/line.scene
+  assert_success
+  run kover --max-memory "$budget" nearest < "$BATS_TEST_TMPDIR"/line.scene
+  [ "$status" -eq 1 ]
+  assert_output "error: memory budget of $budget bytes exceeded"
+}
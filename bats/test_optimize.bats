@@ -0,0 +1,101 @@
+setup() {
+  load 'bats-support/load'
+  load 'bats-assert/load'
+  root_dir="$(cd "$( dirname "$BATS_TEST_FILENAME" )/.." >/dev/null 2>&1 && pwd)"
+  PATH="$root_dir/bin:$PATH"
+  examples_dir="$root_dir/examples"
+}
+
+# Normal usage
+# ------------
+
+@test "kover optimize --pareto runs correctly on an empty scene" {
+  run kover optimize --pareto < "$examples_dir"/empty.scene
+  assert_success
+  assert_output - <<EOT
+begin scene
+end scene
+EOT
+}
+
+@test "kover optimize --pareto prints each trade-off as a scene" {
+  run kover optimize --pareto < "$examples_dir"/2b3a.scene
+  assert_success
+  assert_output - <<EOT
+begin scene
+  building b1 0 0 1 1
+  building b2 10 0 1 1
+  antenna a1 5 0 7
+end scene
+begin scene
+  building b1 0 0 1 1
+  building b2 10 0 1 1
+  antenna a2 0 0 2
+  antenna a3 10 0 2
+end scene
+EOT
+}
+
+@test "kover optimize --pareto keeps the sectors of the antennas" {
+  run kover optimize --pareto < "$examples_dir"/2b3s.scene
+  assert_success
+  assert_output - <<EOT
+begin scene
+  building b1 6 0 1 1
+  building b2 -6 0 1 1
+  antenna s3 0 -1 10 0 300
+end scene
+EOT
+}
+
+@test "kover optimize --pareto prints scenes kover can read back" {
+  run bash -c "kover optimize --pareto < '$examples_dir'/2b3a.scene | kover summarize"
+  assert_success
+  assert_output - <<EOT
+A scene with 2 buildings and 1 antenna
+A scene with 2 buildings and 2 antennas
+EOT
+}
+
+@test "kover optimize --pareto finds the same trade-offs with several threads" {
+  awk 'BEGIN { srand(2); print "begin scene"; for (i = 0; i < 300; i++) print "  building b" i " " i % 20 * 10 " " int(i / 20) * 10 " 2 2"; for (i = 0; i < 300; ) { x = int(rand() * 200); y = int(rand() * 150); if (!((x, y) in seen)) { seen[x, y] = 1; print "  antenna a" i " " x " " y " " 10 + int(rand() * 31); i++ } }; print "end scene" }' \
+    > "$BATS_TEST_TMPDIR"/random.scene
+  kover optimize --pareto --threads 1 < "$BATS_TEST_TMPDIR"/random.scene > "$BATS_TEST_TMPDIR"/sequential.out
+  run kover optimize --pareto --threads 8 < "$BATS_TEST_TMPDIR"/random.scene
+  assert_success
+  assert_output "$(cat "$BATS_TEST_TMPDIR"/sequential.out)"
+  assert_line --index 0 "begin scene"
+}
+
+@test "kover optimize --pareto reports a building without any covering antenna" {
+  run kover optimize --pareto < "$examples_dir"/1b.scene
+  assert_success
+  assert_output "no cover (building b1 is not covered by any antenna)"
+}
+
+# Wrong usage
+# -----------
+
+@test "kover optimize reports an error without a mode" {
+  run kover optimize < "$examples_dir"/2b3a.scene
+  [ "$status" -eq 1 ]
+  assert_output "error: optimize expects a mode (--pareto)"
+}
+
+@test "kover optimize reports an error with an unknown argument" {
+  run kover optimize --pareto --fast < "$examples_dir"/2b3a.scene
+  [ "$status" -eq 1 ]
+  assert_output "error: argument '--fast' is not accepted by subcommand 'optimize'"
+}
+
+@test "kover optimize --pareto --threads reports an error with an invalid number" {
+  run kover optimize --pareto --threads 65 < "$examples_dir"/2b3a.scene
+  [ "$status" -eq 1 ]
+  assert_output "error: invalid value \"65\" for argument '--threads'"
+}
+
+@test "kover watch optimize reports an error without a mode" {
+  run kover watch optimize "$examples_dir"/2b3a.scene
+  [ "$status" -eq 1 ]
+  assert_output "error: optimize expects a mode (--pareto)"
+}
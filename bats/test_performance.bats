@@ -0,0 +1,104 @@
+# Performance regression gate: each subcommand must scale quasi-linearly with
+# the number of entities, relative to a calibration run on the smallest scene
+
+setup_file() {
+  for n in 10000 100000 1000000; do
+    awk -v n="$n" 'BEGIN {
+      print "begin scene"
+      columns = int(sqrt(n / 2)) + 1
+      for (i = 0; i < n / 2; i++) {
+        x = (i % columns) * 10; y = int(i / columns) * 10
+        # Identifiers in a scrambled order, so that sorting has work to do
+        printf "  building b%d %d %d 2 2\n", (i * 7919) % (n / 2), x, y
+        printf "  antenna a%d %d %d 5\n", (i * 7919) % (n / 2), x + 5, y + 5
+      }
+      print "end scene"
+    }' > "$BATS_FILE_TMPDIR/$n.scene"
+    # Small buildings first, then large ones on the rows between them, so
+    # that each large building is checked against a level crowded elsewhere
+    awk -v n="$n" 'BEGIN {
+      print "begin scene"
+      large = int(n / 3)
+      columns = int(sqrt(large)) + 1
+      for (i = 0; i < n - large; i++) {
+        x = (i % (2 * columns)) * 501; y = int(i / (2 * columns)) * 1500 + 750
+        printf "  building s%d %d %d 1 1\n", i, x, y
+      }
+      for (i = 0; i < large; i++) {
+        x = (i % columns) * 1002; y = int(i / columns) * 1500
+        printf "  building l%d %d %d 500 500\n", i, x, y
+      }
+      print "end scene"
+    }' > "$BATS_FILE_TMPDIR/mixed-$n.scene"
+    # Antennas packed in a small square, plus one far outlier stretching the
+    # extent of the scene
+    awk -v n="$n" 'BEGIN {
+      print "begin scene"
+      columns = int(sqrt(n)) + 1
+      for (i = 0; i < n - 1; i++) printf "  antenna a%d %d %d 1\n", i, i % columns, int(i / columns)
+      print "  antenna outlier 999999999 999999999 1"
+      print "end scene"
+    }' > "$BATS_FILE_TMPDIR/clustered-$n.scene"
+  done
+}
+
+setup() {
+  load 'bats-support/load'
+  load 'bats-assert/load'
+  root_dir="$(cd "$( dirname "$BATS_TEST_FILENAME" )/.." >/dev/null 2>&1 && pwd)"
+  PATH="$root_dir/bin:$PATH"
+}
+
+# Prints the best time in seconds of three runs of a subcommand on a scene
+best_time() {
+  local best=""
+  for run in 1 2 3; do
+    local start=$EPOCHREALTIME
+    kover "$1" < "$2" > /dev/null
+    best=$(awk -v start="$start" -v end="$EPOCHREALTIME" -v best="$best" \
+      'BEGIN { t = end - start; print (best == "" || t < best) ? t : best }')
+  done
+  echo "$best"
+}
+
+# Runs a subcommand on scenes 10 and 100 times larger than the calibration
+# scene, each within a budget of 4 times the linear extrapolation, plus a
+# fixed allowance for process startup and timer noise. The optional second
+# argument selects the family of scenes (prefix of the scene files)
+assert_scales_linearly() {
+  local prefix="${2:+$2-}"
+  local calibration=$(best_time "$1" "$BATS_FILE_TMPDIR/${prefix}10000.scene")
+  for factor in 10 100; do
+    local n=$((10000 * factor))
+    local budget=$(awk -v t="$calibration" -v f="$factor" 'BEGIN { print t * f * 4 + 0.25 }')
+    run timeout "$budget" kover "$1" < "$BATS_FILE_TMPDIR/$prefix$n.scene"
+    if [ "$status" -eq 124 ]; then
+      fail "kover $1 exceeded its budget of ${budget}s on $n entities"
+    fi
+    assert_success
+  done
+}
+
+@test "kover bounding-box scales linearly with the number of entities" {
+  assert_scales_linearly bounding-box
+}
+
+@test "kover describe scales linearly with the number of entities" {
+  assert_scales_linearly describe
+}
+
+@test "kover summarize scales linearly with the number of entities" {
+  assert_scales_linearly summarize
+}
+
+@test "kover summarize scales linearly with buildings of mixed sizes" {
+  assert_scales_linearly summarize mixed
+}
+
+@test "kover nearest scales linearly with the number of entities" {
+  assert_scales_linearly nearest
+}
+
+@test "kover nearest scales linearly with clustered antennas and an outlier" {
+  assert_scales_linearly nearest clustered
+}
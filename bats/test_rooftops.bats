@@ -0,0 +1,36 @@
+setup() {
+  load 'bats-support/load'
+  load 'bats-assert/load'
+  root_dir="$(cd "$( dirname "$BATS_TEST_FILENAME" )/.." >/dev/null 2>&1 && pwd)"
+  PATH="$root_dir/bin:$PATH"
+  examples_dir="$root_dir/examples"
+}
+
+# Normal usage
+# ------------
+
+@test "kover rooftops runs correctly on an empty scene" {
+  run kover rooftops < "$examples_dir"/empty.scene
+  assert_success
+  assert_output "0 antennas on rooftops, 0 ground-mounted"
+}
+
+@test "kover rooftops reports a ground-mounted antenna" {
+  run kover rooftops < "$examples_dir"/1b1a.scene
+  assert_success
+  assert_output - <<EOT
+0 antennas on rooftops, 1 ground-mounted
+  antenna a1 ground-mounted
+EOT
+}
+
+@test "kover rooftops finds the building of each antenna" {
+  run kover rooftops < "$examples_dir"/2b3a.scene
+  assert_success
+  assert_output - <<EOT
+2 antennas on rooftops, 1 ground-mounted
+  antenna a1 ground-mounted
+  antenna a2 on building b1
+  antenna a3 on building b2
+EOT
+}
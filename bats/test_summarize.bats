@@ -45,6 +45,14 @@ setup() {
   assert_output "A scene with 1 building and 1 antenna"
 }
 
+@test "kover summarize runs correctly on a stream of scenes" {
+  run kover summarize < "$examples_dir"/stream.scene
+  assert_success
+  assert_line --index 0 "A scene with 1 building"
+  assert_line --index 1 "A scene with 2 antennas"
+  assert_line --index 2 "An empty scene"
+}
+
 # Wrong lines
 # -----------
 
@@ -66,6 +74,12 @@ setup() {
   assert_output "error: last line must be exactly 'end scene'"
 }
 
+@test "kover summarize reports an error in a later scene of a stream" {
+  run kover summarize < "$examples_dir"/stream_overlapping.invalid
+  [ "$status" -eq 1 ]
+  assert_line --index 1 "error: buildings b1 and b2 are overlapping"
+}
+
 # Wrong buildings
 # ---------------
 
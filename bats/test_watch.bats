@@ -0,0 +1,141 @@
+setup() {
+  load 'bats-support/load'
+  load 'bats-assert/load'
+  root_dir="$(cd "$( dirname "$BATS_TEST_FILENAME" )/.." >/dev/null 2>&1 && pwd)"
+  PATH="$root_dir/bin:$PATH"
+  examples_dir="$root_dir/examples"
+  scene_file="$BATS_TEST_TMPDIR/watched.scene"
+}
+
+# Normal usage
+# ------------
+
+@test "kover watch evaluates the file when it starts" {
+  cp "$examples_dir"/1b.scene "$scene_file"
+  run timeout 1 kover watch summarize "$scene_file"
+  [ "$status" -eq 124 ]
+  assert_output "A scene with 1 building"
+}
+
+@test "kover watch evaluates the file again when it is modified" {
+  cp "$examples_dir"/1b.scene "$scene_file"
+  timeout 2 kover watch summarize "$scene_file" > "$BATS_TEST_TMPDIR/output" &
+  sleep 0.5
+  cp "$examples_dir"/2a.scene "$scene_file"
+  wait
+  run cat "$BATS_TEST_TMPDIR/output"
+  assert_line --index 0 "A scene with 1 building"
+  assert_line --index 1 "A scene with 2 antennas"
+}
+
+@test "kover watch ignores modifications that keep the same content" {
+  cp "$examples_dir"/1b.scene "$scene_file"
+  timeout 2 kover watch summarize "$scene_file" > "$BATS_TEST_TMPDIR/output" &
+  sleep 0.5
+  touch "$scene_file"
+  wait
+  run cat "$BATS_TEST_TMPDIR/output"
+  assert_output "A scene with 1 building"
+}
+
+@test "kover watch republishes a previous version from its result cache" {
+  cp "$examples_dir"/1b.scene "$scene_file"
+  timeout 2 kover --stats watch summarize "$scene_file" \
+    > "$BATS_TEST_TMPDIR/output" 2> "$BATS_TEST_TMPDIR/stats" &
+  sleep 0.5
+  cp "$examples_dir"/2a.scene "$scene_file"
+  sleep 0.5
+  cp "$examples_dir"/1b.scene "$scene_file"
+  wait
+  run cat "$BATS_TEST_TMPDIR/output"
+  assert_line --index 0 "A scene with 1 building"
+  assert_line --index 1 "A scene with 2 antennas"
+  assert_line --index 2 "A scene with 1 building"
+  run grep '^kover_cache_' "$BATS_TEST_TMPDIR/stats"
+  assert_line --index 6 "kover_cache_hits_total 1"
+  assert_line --index 7 "kover_cache_misses_total 2"
+}
+
+@test "kover watch evicts the least recently used results beyond --cache-size" {
+  cp "$examples_dir"/1b.scene "$scene_file"
+  timeout 2 kover --stats --cache-size 64 watch summarize "$scene_file" \
+    > "$BATS_TEST_TMPDIR/output" 2> "$BATS_TEST_TMPDIR/stats" &
+  sleep 0.5
+  cp "$examples_dir"/2a.scene "$scene_file"
+  sleep 0.5
+  cp "$examples_dir"/1b.scene "$scene_file"
+  wait
+  run cat "$BATS_TEST_TMPDIR/output"
+  assert_line --index 2 "A scene with 1 building"
+  run grep '^kover_cache_' "$BATS_TEST_TMPDIR/stats"
+  assert_line --index 6 "kover_cache_hits_total 0"
+  assert_line --index 7 "kover_cache_misses_total 3"
+  assert_line --index 8 "kover_cache_evictions_total 2"
+}
+
+@test "kover watch appends the trace of each version to a complete trace file" {
+  cp "$examples_dir"/1b.scene "$scene_file"
+  timeout 2 kover --trace "$BATS_TEST_TMPDIR/trace.json" watch summarize "$scene_file" \
+    > /dev/null &
+  sleep 0.5
+  run grep -c '"name":"read_scene","ph":"B"' "$BATS_TEST_TMPDIR/trace.json"
+  assert_output "1"
+  cp "$examples_dir"/2a.scene "$scene_file"
+  wait
+  run grep -c '"name":"read_scene","ph":"B"' "$BATS_TEST_TMPDIR/trace.json"
+  assert_output "2"
+  run tail -n 1 "$BATS_TEST_TMPDIR/trace.json"
+  assert_output '],"displayTimeUnit":"ms"}'
+}
+
+@test "kover watch publishes nothing from an invalid version" {
+  cp "$examples_dir"/stream_overlapping.invalid "$scene_file"
+  run timeout 1 kover watch summarize "$scene_file"
+  [ "$status" -eq 124 ]
+  assert_output "error: buildings b1 and b2 are overlapping"
+}
+
+@test "kover watch accounts the file content and the results it renders" {
+  cp "$examples_dir"/1b.scene "$scene_file"
+  run bash -c "timeout 1 kover --stats watch summarize '$scene_file' 2>&1 > /dev/null"
+  [ "$status" -eq 124 ]
+  assert_line --regexp '^kover_memory_peak_bytes\{subsystem="input"\} [1-9][0-9]*$'
+  assert_line --regexp '^kover_memory_peak_bytes\{subsystem="output"\} [1-9][0-9]*$'
+}
+
+@test "kover watch publishes nothing from a version exceeding --max-memory" {
+  # The budget lies halfway between the peaks of summarize, which only loads
+  # the scene, and describe, which also sorts and renders its records
+  awk 'BEGIN { print "begin scene"; for (i = 0; i < 20000; i++) print "  antenna a" i " " 3 * i " 0 1"; print "end scene" }' \
+    > "$scene_file"
+  for subcommand in summarize describe; do
+    timeout 1 kover --stats watch "$subcommand" "$scene_file" \
+      > /dev/null 2> "$BATS_TEST_TMPDIR/$subcommand.stats" || true
+  done
+  local budget=$(cat "$BATS_TEST_TMPDIR"/summarize.stats "$BATS_TEST_TMPDIR"/describe.stats |
+    awk '/^kover_memory_peak_bytes\{subsystem="total"\}/ { sum += $2 } END { print int(sum / 2) }')
+  run timeout 1 kover --max-memory "$budget" watch describe "$scene_file"
+  [ "$status" -eq 124 ]
+  assert_output "error: memory budget of $budget bytes exceeded"
+}
+
+# Wrong usage
+# -----------
+
+@test "kover watch reports an error without a subcommand and a file" {
+  run kover watch summarize
+  [ "$status" -eq 1 ]
+  assert_output "error: watch expects a subcommand and a file"
+}
+
+@test "kover watch reports an error with an unrecognized subcommand" {
+  run kover watch help "$examples_dir"/1b.scene
+  [ "$status" -eq 1 ]
+  assert_output "error: subcommand 'help' is not recognized"
+}
+
+@test "kover watch reports an error when the file does not exist" {
+  run kover watch summarize "$examples_dir"/missing.scene
+  [ "$status" -eq 1 ]
+  assert_output "error: cannot open file '$examples_dir/missing.scene'"
+}
@@ -0,0 +1,322 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  kover_bench.c
+ *
+ *    Description:  Microbenchmarks of the kover kernel functions
+ *                  Times each hot function in isolation over generated data of
+ *                  several sizes and reports percentiles of the time per call
+ *
+ *       Compiler:  gcc
+ *
+ * =====================================================================================
+ */
+
+#define KOVER_NO_MAIN
+#include "../src/kover.c"
+
+// --------------------------------------------------------
+// SECTION: CONSTANTS AND DEFINITIONS
+// --------------------------------------------------------
+
+#define WARMUP_RUNS 3
+#define MEASURED_RUNS 31
+#define BENCH_SEED 42
+
+// Generated ids are bounded so that "b%u" always fits in MAX_ID_LENGTH
+#define MAX_BENCH_INDEX 1000000
+
+// Buffer large enough for any int printed with "%d"
+#define INT_STRING_LENGTH 12
+
+// Number of elements of the generated data sets
+const size_t BENCH_SIZES[] = {1000, 10000, 100000};
+const int NUM_BENCH_SIZES = 3;
+
+// --------------------------------------------------------
+// SECTION: DATA STRUCTURES
+// --------------------------------------------------------
+
+// Data shared by all the benchmarks of one size
+typedef struct {
+    size_t size;                        // Number of generated elements
+    char (*integers)[MAX_ARG_LENGTH];   // Valid and invalid integer strings
+    char (*ids)[MAX_ID_LENGTH];         // Valid and invalid identifiers
+    const char** id_pointers;           // Pointers to the building identifiers
+    char (*lines)[MAX_LINE_LENGTH];     // Building lines
+    Building* probes;                   // Buildings to look for in the scene
+    Scene scene;                        // Scene of size buildings and antennas
+} BenchData;
+
+// Benchmarked kernel: runs over all the data, returns a checksum
+typedef unsigned long long (*BenchKernel)(const BenchData* data);
+
+// Benchmark description
+typedef struct {
+    const char* name;           // Name of the benchmarked function
+    BenchKernel kernel;         // Kernel calling the function size times
+} Benchmark;
+
+// --------------------------------------------------------
+// SECTION: FUNCTION PROTOTYPES AND DOCUMENTATION
+// --------------------------------------------------------
+
+/**
+ * @brief Returns the next value of the deterministic generator
+ * @param state Generator state
+ * @return Pseudo-random 32-bit value
+ */
+unsigned int next_random(unsigned long long* state);
+
+/**
+ * @brief Generates the data of one benchmark size, exits if memory is exhausted
+ * @param data Output data
+ * @param size Number of elements to generate
+ */
+void generate_data(BenchData* data, size_t size);
+
+/**
+ * @brief Frees the data of one benchmark size
+ * @param data Data to free
+ */
+void free_data(BenchData* data);
+
+/**
+ * @brief Comparison function for sorting timings
+ * @param a First timing
+ * @param b Second timing
+ * @return Negative if a<b, 0 if equal, positive if a>b
+ */
+int compare_timings(const void* a, const void* b);
+
+/**
+ * @brief Times a benchmark and prints its percentiles
+ * @param benchmark Benchmark to run
+ * @param data Data to run the benchmark on
+ */
+void run_benchmark(const Benchmark* benchmark, const BenchData* data);
+
+// --------------------------------------------------------
+// SECTION: DATA GENERATION FUNCTIONS
+// --------------------------------------------------------
+
+unsigned int next_random(unsigned long long* state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (unsigned int)(*state >> 33);
+}
+
+void generate_data(BenchData* data, size_t size) {
+    unsigned long long state = BENCH_SEED;
+    data->size = size;
+    data->integers = malloc(size * sizeof(*data->integers));
+    data->ids = malloc(size * sizeof(*data->ids));
+    data->id_pointers = malloc(size * sizeof(*data->id_pointers));
+    data->lines = malloc(size * sizeof(*data->lines));
+    data->probes = malloc(size * sizeof(*data->probes));
+    if (!data->integers || !data->ids || !data->id_pointers || !data->lines || !data->probes) {
+        print_error_memory();
+        exit(ERROR);
+    }
+    init_scene(&data->scene);
+
+    const char* invalid_integers[] = {"01", "-", "12a", "--3"};
+    const char* invalid_ids[] = {"9lives", "b^", "a-b", ""};
+    int columns = (int)sqrt((double)size) + 1;
+
+    for (size_t i = 0; i < size; i++) {
+        unsigned int r = next_random(&state);
+        unsigned int index = (unsigned int)(i % MAX_BENCH_INDEX);
+        if (r % 8 == 0) {
+            snprintf(data->integers[i], MAX_ARG_LENGTH, "%s", invalid_integers[r % 4]);
+            snprintf(data->ids[i], MAX_ID_LENGTH, "%s", invalid_ids[(r >> 3) % 4]);
+        } else {
+            snprintf(data->integers[i], MAX_ARG_LENGTH, "%d", (int)(r % 2000001) - 1000000);
+            snprintf(data->ids[i], MAX_ID_LENGTH, "b_%u", r % 100000000);
+        }
+
+        // Disjoint buildings on a grid, with antennas between them
+        Building b;
+        snprintf(b.id, MAX_ID_LENGTH, "b%u", index);
+        b.x = (int)(i % columns) * 10;
+        b.y = (int)(i / columns) * 10;
+        b.w = 1 + r % 4;
+        b.h = 1 + (r >> 2) % 4;
+        if (!add_building(&data->scene, &b)) {
+            print_error_memory();
+            exit(ERROR);
+        }
+
+        Antenna a;
+        char a_id[MAX_ID_LENGTH], r_str[MAX_ARG_LENGTH];
+        snprintf(r_str, MAX_ARG_LENGTH, "%u", 1 + r % 20);
+        snprintf(a_id, MAX_ID_LENGTH, "a%u", index);
+        char x_str[INT_STRING_LENGTH], y_str[INT_STRING_LENGTH];
+        snprintf(x_str, INT_STRING_LENGTH, "%d", b.x + 5);
+        snprintf(y_str, INT_STRING_LENGTH, "%d", b.y + 5);
+        construct_antenna(&a, a_id, x_str, y_str, r_str, "", "");
+        if (!add_antenna(&data->scene, &a)) {
+            print_error_memory();
+            exit(ERROR);
+        }
+
+        snprintf(data->lines[i], MAX_LINE_LENGTH, "  building %s %d %d %d %d",
+                 b.id, b.x, b.y, b.w, b.h);
+
+        // Half of the probes overlap an existing building, half fall in gaps
+        Building* probe = &data->probes[i];
+        unsigned int target = next_random(&state) % (index + 1);
+        snprintf(probe->id, MAX_ID_LENGTH, r % 2 ? "b%u" : "m%u", target);
+        probe->x = (int)(target % columns) * 10 + (r % 2 ? 1 : 5);
+        probe->y = (int)(target / columns) * 10 + (r % 2 ? 1 : 5);
+        probe->w = 1;
+        probe->h = 1;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        data->id_pointers[i] = data->scene.buildings[i].id;
+    }
+}
+
+void free_data(BenchData* data) {
+    free(data->integers);
+    free(data->ids);
+    free(data->id_pointers);
+    free(data->lines);
+    free(data->probes);
+    free_scene(&data->scene);
+}
+
+// --------------------------------------------------------
+// SECTION: KERNELS
+// --------------------------------------------------------
+
+unsigned long long kernel_is_valid_integer(const BenchData* data) {
+    unsigned long long sum = 0;
+    for (size_t i = 0; i < data->size; i++) sum += is_valid_integer(data->integers[i]);
+    return sum;
+}
+
+unsigned long long kernel_is_valid_id(const BenchData* data) {
+    unsigned long long sum = 0;
+    for (size_t i = 0; i < data->size; i++) sum += is_valid_id(data->ids[i]);
+    return sum;
+}
+
+unsigned long long kernel_buildings_overlap(const BenchData* data) {
+    unsigned long long sum = 0;
+    for (size_t i = 0; i < data->size; i++) {
+        sum += buildings_overlap(&data->probes[i], &data->scene.buildings[i]);
+    }
+    return sum;
+}
+
+unsigned long long kernel_compute_bounding_box(const BenchData* data) {
+    int min_x, max_x, min_y, max_y;
+    compute_bounding_box(&data->scene, &min_x, &max_x, &min_y, &max_y);
+    return (unsigned long long)(max_x - min_x) + (max_y - min_y);
+}
+
+unsigned long long kernel_compare_ids(const BenchData* data) {
+    unsigned long long sum = 0;
+    for (size_t i = 1; i < data->size; i++) {
+        sum += compare_ids(&data->id_pointers[i - 1], &data->id_pointers[i]) > 0;
+    }
+    return sum;
+}
+
+unsigned long long kernel_extract_building_args(const BenchData* data) {
+    char id[MAX_ID_LENGTH];
+    char x_str[MAX_ARG_LENGTH], y_str[MAX_ARG_LENGTH];
+    char w_str[MAX_ARG_LENGTH], h_str[MAX_ARG_LENGTH];
+    unsigned long long sum = 0;
+    for (size_t i = 0; i < data->size; i++) {
+        sum += extract_building_args(data->lines[i], id, x_str, y_str, w_str, h_str, 0);
+    }
+    return sum;
+}
+
+unsigned long long kernel_id_index_find(const BenchData* data) {
+    unsigned long long sum = 0;
+    for (size_t i = 0; i < data->size; i++) {
+        sum += id_index_find(&data->scene.building_ids, data->scene.buildings,
+                             sizeof(Building), data->probes[i].id) >= 0;
+    }
+    return sum;
+}
+
+unsigned long long kernel_find_overlapping_building(const BenchData* data) {
+    unsigned long long sum = 0;
+    for (size_t i = 0; i < data->size; i++) {
+        sum += find_overlapping_building(&data->scene, &data->probes[i]) >= 0;
+    }
+    return sum;
+}
+
+unsigned long long kernel_find_antenna_at(const BenchData* data) {
+    unsigned long long sum = 0;
+    for (size_t i = 0; i < data->size; i++) {
+        sum += find_antenna_at(&data->scene, data->probes[i].x + 4, data->probes[i].y + 4) >= 0;
+    }
+    return sum;
+}
+
+// Benchmarked functions
+const Benchmark BENCHMARKS[] = {
+    {"is_valid_integer", kernel_is_valid_integer},
+    {"is_valid_id", kernel_is_valid_id},
+    {"buildings_overlap", kernel_buildings_overlap},
+    {"compute_bounding_box", kernel_compute_bounding_box},
+    {"compare_ids", kernel_compare_ids},
+    {"extract_building_args", kernel_extract_building_args},
+    {"id_index_find", kernel_id_index_find},
+    {"find_overlapping_building", kernel_find_overlapping_building},
+    {"find_antenna_at", kernel_find_antenna_at}
+};
+const int NUM_BENCHMARKS = 9;
+
+// --------------------------------------------------------
+// SECTION: HARNESS FUNCTIONS
+// --------------------------------------------------------
+
+int compare_timings(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Sink for the kernel checksums, so that the compiler keeps the calls
+volatile unsigned long long bench_sink;
+
+void run_benchmark(const Benchmark* benchmark, const BenchData* data) {
+    double timings[MEASURED_RUNS];
+
+    for (int run = 0; run < WARMUP_RUNS + MEASURED_RUNS; run++) {
+        double start = now_seconds();
+        bench_sink += benchmark->kernel(data);
+        double elapsed = now_seconds() - start;
+        if (run >= WARMUP_RUNS) timings[run - WARMUP_RUNS] = elapsed * 1e9 / data->size;
+    }
+
+    qsort(timings, MEASURED_RUNS, sizeof(double), compare_timings);
+    printf("%-26s %8zu %10.2f %10.2f %10.2f %10.2f\n", benchmark->name, data->size,
+           timings[0], timings[MEASURED_RUNS / 2], timings[MEASURED_RUNS * 9 / 10],
+           timings[MEASURED_RUNS - 1]);
+}
+
+// --------------------------------------------------------
+// SECTION: MAIN FUNCTION
+// --------------------------------------------------------
+
+int main(void) {
+    printf("%-26s %8s %10s %10s %10s %10s\n", "function", "size", "min_ns", "p50_ns",
+           "p90_ns", "max_ns");
+
+    for (int s = 0; s < NUM_BENCH_SIZES; s++) {
+        BenchData data;
+        generate_data(&data, BENCH_SIZES[s]);
+        for (int b = 0; b < NUM_BENCHMARKS; b++) {
+            run_benchmark(&BENCHMARKS[b], &data);
+        }
+        free_data(&data);
+    }
+    return SUCCESS;
+}
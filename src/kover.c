@@ -17,12 +17,37 @@
  * =====================================================================================
  */
 
+// fopencookie and fmemopen, for the accounted buffers of watch mode
+#define _GNU_SOURCE
+
 #include <ctype.h>
+#include <libgen.h>
 #include <limits.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/inotify.h>
+#include <time.h>
+#include <unistd.h>
+
+// Static tracepoints for bpftrace/SystemTap, compiled out unless KOVER_USDT is defined
+#ifdef KOVER_USDT
+#include <sys/sdt.h>
+#define KOVER_PROBE1(name, a) DTRACE_PROBE1(kover, name, a)
+#define KOVER_PROBE2(name, a, b) DTRACE_PROBE2(kover, name, a, b)
+#define KOVER_PROBE3(name, a, b, c) DTRACE_PROBE3(kover, name, a, b, c)
+#else
+#define KOVER_PROBE1(name, a) ((void)0)
+#define KOVER_PROBE2(name, a, b) ((void)0)
+#define KOVER_PROBE3(name, a, b, c) ((void)0)
+#endif
+
+// Defining KOVER_REFERENCE replaces the indexes and the sorted output by the
+// original linear scans, against which make difftest compares the fast paths
 
 // --------------------------------------------------------
 // SECTION: CONSTANTS AND DEFINITIONS
@@ -31,11 +56,70 @@
 // Size and configuration constants
 #define MAX_LINE_LENGTH 51
 #define MAX_ID_LENGTH 11
-#define MAX_BUILDINGS 100
-#define MAX_ANTENNAS 100
+#define INITIAL_CAPACITY 64
 #define MAX_ARGS 6
 #define MAX_ARG_LENGTH 11
 
+// Antenna sector constants (degrees, azimuth measured clockwise from north)
+#define FULL_CIRCLE 360
+#define DEFAULT_AZIMUTH 0
+#define DEFAULT_BEAMWIDTH FULL_CIRCLE
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Watch mode constants
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE)
+#define WATCH_BUFFER_SIZE 4096
+#define DEFAULT_CACHE_SIZE (16 * 1024 * 1024)
+
+// Statistics constants (scene latency buckets are powers of two in microseconds)
+#define STATS_BUCKETS 25
+
+// Cover solver constants (subset checks of the dominance pruning, in
+// buildings visited, beyond which the remaining antennas are all kept)
+#define COVER_DOMINANCE_WORK (1 << 25)
+
+// Cover solver limits (64-bit words of bitsets scanned by default before the
+// best cover found is printed unproven, each node scanning the bitsets of all
+// candidates, and words of bitsets beyond which the exact search is skipped)
+#define COVER_SEARCH_WORK (1LL << 27)
+#define COVER_DENSE_WORDS (1 << 22)
+
+// Trade-off exploration limits (worker threads, each evaluating one lambda)
+#define PARETO_MAX_THREADS 64
+
+// Nearest neighbour constants (distance buckets are powers of two)
+#define DISTANCE_BUCKETS 40
+
+// Hull constants (antenna disks are approximated by regular polygons)
+#define DEFAULT_DISK_SIDES 32
+#define MIN_DISK_SIDES 3
+#define MAX_DISK_SIDES 4096
+
+// Stream processing limits (scenes processed at once with --jobs)
+#define MAX_JOBS 64
+
+// Trace constants
+#define TRACE_PID 1
+#define TRACE_TID 1
+#define TRACE_HEADER "{\"traceEvents\":["
+#define TRACE_TRAILER "\n],\"displayTimeUnit\":\"ms\"}\n"
+
+// Memory arena constants
+#define ARENA_CHUNK_SIZE (64 * 1024)
+#define ARENA_ALIGNMENT 8
+
+// Spatial index constants (one grid level per power of two of building size)
+#define GRID_LEVELS 40
+#define NO_ENTRY -1
+
+// Summary cells of depth d group 2^(d * GRID_SUMMARY_SHIFT) cells per side,
+// enough depths for a walk over any int box to start from a few cells
+#define GRID_SUMMARY_SHIFT 3
+#define GRID_SUMMARY_DEPTHS 11
+#define GRID_WALK_CELLS 64
+
 // Return codes
 #define SUCCESS 0
 #define ERROR 1
@@ -43,11 +127,18 @@
 // Valid subcommands
 const char* VALID_SUBCOMMANDS[] = {
     "bounding-box",  // Calculate and display scene bounding box
+    "cover",         // Find a minimum set of antennas covering every building
+    "coverage",      // Count the antennas covering each building
     "describe",      // Show detailed scene description
     "help",          // Display help message
-    "summarize"      // Show scene summary
+    "hull",          // Compute the tight enclosures of the scene
+    "nearest",       // Find the nearest neighbour of each entity
+    "optimize",      // Explore the trade-offs between antennas and their radii
+    "rooftops",      // Find the building each antenna stands on
+    "summarize",     // Show scene summary
+    "watch"          // Rerun a subcommand each time a file changes
 };
-const int NUM_SUBCOMMANDS = 4;
+const int NUM_SUBCOMMANDS = 11;
 
 // --------------------------------------------------------
 // SECTION: DATA STRUCTURES
@@ -68,16 +159,341 @@ typedef struct {
     int x;                      // X coordinate
     int y;                      // Y coordinate
     int r;                      // Coverage radius
+    int azimuth;                // Sector direction, clockwise from north
+    int beamwidth;              // Sector aperture (360 for omnidirectional)
+    int min_x;                  // Precomputed sector bounding box
+    int max_x;
+    int min_y;
+    int max_y;
 } Antenna;
 
+// Runtime statistics, printed on stderr with --stats
+typedef struct {
+    unsigned long long scenes;          // Scenes loaded and processed
+    unsigned long long lines;           // Lines read
+    unsigned long long buildings;       // Buildings loaded
+    unsigned long long antennas;        // Antennas loaded
+    unsigned long long id_lookups;      // Identifier index lookups
+    unsigned long long id_probes;       // Identifier index slots visited
+    unsigned long long grid_lookups;    // Grid index queries
+    unsigned long long grid_visits;     // Grid index entries visited
+    unsigned long long cover_nodes;     // Nodes explored by the cover solver
+    unsigned long long cache_hits;      // Watched versions served from the cache
+    unsigned long long cache_misses;    // Watched versions evaluated
+    unsigned long long cache_evictions; // Cached results evicted
+    unsigned long long scene_latency[STATS_BUCKETS + 1]; // Scenes per latency bucket
+    double scene_seconds;               // Total time spent on scenes
+} Stats;
+
+// Statistics of the current thread (those of the scene workers are merged into
+// the main thread's once their scene is published)
+_Thread_local Stats stats;
+
+// Trace event, in the Chrome trace event format
+typedef struct {
+    const char* name;           // Name of the traced phase
+    char phase;                 // 'B' when the phase begins, 'E' when it ends
+    double timestamp;           // Microseconds since the start of the run
+    int tid;                    // Thread the phase ran on
+} TraceEvent;
+
+// Trace of the internal phases, written with --trace
+typedef struct {
+    const char* path;           // File the trace is written to, NULL if disabled
+    TraceEvent* events;         // Recorded events not written yet
+    unsigned int num_events;    // Number of recorded events not written yet
+    unsigned long long written; // Number of events already in the file
+    unsigned int capacity;      // Allocated events
+    double start;               // Start of the run, in seconds
+} Trace;
+
+// Trace of the current run
+Trace trace;
+
+// Trace thread of the current thread, each scene worker getting its own
+_Thread_local int trace_tid = TRACE_TID;
+
+// Serializes the events recorded by the scene workers
+pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Command-line options
+typedef struct {
+    bool stats;                 // Print statistics on stderr
+    const char* trace_path;     // Chrome trace output file, NULL if disabled
+    size_t max_memory;          // Memory budget in bytes, 0 if unlimited
+    size_t cache_size;          // Capacity of the watch result cache in bytes
+    int min_antenna_spacing;    // Minimum distance between antennas, 0 if unchecked
+    int jobs;                   // Scenes processed at once, 1 to process them in turn
+} Options;
+
+// Optional validation rules
+typedef struct {
+    int min_antenna_spacing;    // Minimum distance between antennas, 0 if unchecked
+    int spacing_level;          // Smallest grid level whose cells are that large
+} ValidationRules;
+
+// Validation rules of the current run
+ValidationRules rules;
+
+// Arguments following the subcommand
+typedef struct {
+    bool pareto;                // optimize: explore the antennas/radii trade-offs
+    int min_coverage;           // coverage: antennas each building should have
+    int disk_sides;             // hull: sides of the polygons replacing antenna disks
+    int max_nodes;              // cover: nodes of the exact search, 0 to scale them to the scene
+    int threads;                // optimize: worker threads, 0 for one per online processor
+} SubcommandArgs;
+
+// Subcommand arguments of the current run
+SubcommandArgs subcommand_args;
+
+// Memory subsystems allocations are accounted to
+typedef enum {
+    MEM_SCENE,                  // Buildings and antennas arrays
+    MEM_ID_INDEX,               // Identifier indexes
+    MEM_GRID_INDEX,             // Grid indexes
+    MEM_OUTPUT,                 // Output buffers
+    MEM_TRACE,                  // Trace events
+    MEM_CACHE,                  // Watch result cache
+    MEM_SOLVER,                 // Cover solver bitsets
+    MEM_INPUT,                  // Content of the watched file
+    MEM_SUBSYSTEMS              // Number of subsystems
+} MemSubsystem;
+
+// Names of the memory subsystems, as reported by --stats
+const char* MEM_SUBSYSTEM_NAMES[] = {
+    "scene",
+    "id_index",
+    "grid_index",
+    "output",
+    "trace",
+    "cache",
+    "solver",
+    "input"
+};
+
+// Accounting of the memory allocated by kover
+typedef struct {
+    size_t current[MEM_SUBSYSTEMS];     // Bytes currently allocated per subsystem
+    size_t peak[MEM_SUBSYSTEMS];        // Highest allocation per subsystem
+    size_t total;                       // Bytes currently allocated
+    size_t total_peak;                  // Highest total allocation
+    size_t budget;                      // Maximum total allocation, 0 if unlimited
+    bool budget_exceeded;               // Whether an allocation hit the budget
+} MemoryAccount;
+
+// Memory accounting of the current run
+MemoryAccount memory;
+
+// Serializes the accounting of the scene workers
+pthread_mutex_t memory_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Search state of the exact minimum cover solver
+typedef struct {
+    int num_buildings;          // Buildings of the scene
+    int num_antennas;           // Antennas of the scene
+    int words;                  // 64-bit words per building bitset
+    int num_candidates;         // Antennas left after dominance pruning
+    int* candidates;            // Antenna of each candidate
+    int* set_buildings;         // Buildings covered by each candidate, by candidate
+    int* set_offsets;           // Start of the buildings of each candidate
+    uint64_t* sets;             // Buildings covered by each candidate (bitsets), NULL
+                                // unless built for the exact search
+    int* building_candidates;   // Candidates covering each building, by building
+    int* building_offsets;      // Start of the candidates of each building
+    int num_memberships;        // Size of building_candidates
+    int memberships_capacity;   // Allocated set_buildings and building_candidates
+    uint64_t* uncovered;        // Uncovered buildings at each search depth (bitsets)
+    int* current;               // Candidates of the cover being built
+    int* best;                  // Candidates of the smallest cover found
+    int best_size;              // Size of the smallest cover found
+    int* marks;                 // Stamp of the last bound computation using each candidate
+    int stamp;                  // Stamp of the current bound computation
+    int* excluded;              // Positive for candidates excluded from the current branch
+    int* counts;                // Candidates left to each building at the current node
+    int* pending;               // Buildings left to pack in the current lower bound
+    int* branch_order;          // Candidates of the branches of each depth, stacked by depth
+    int* branch_gains;          // Gain of each stacked candidate
+    int branch_top;             // End of the branches of the current path
+    long long nodes_left;       // Nodes the exact search may still explore
+    bool stopped;               // Whether the search ran out of nodes
+} CoverSearch;
+
+// Entry of a max-heap of candidates
+typedef struct {
+    double priority;            // Priority of the candidate when it was pushed
+    int item;                   // Candidate
+} HeapEntry;
+
+// Solution of the antennas/radii trade-off exploration
+typedef struct {
+    int size;                   // Antennas of the solution
+    long long radii;            // Sum of the radii of its antennas
+    int* members;               // Candidates of the solution, in scene order
+} ParetoSolution;
+
+// Incremental state of the antennas/radii trade-off exploration
+typedef struct {
+    int* gains;                 // Uncovered buildings each candidate would cover
+    int* coverage;              // Selected candidates covering each building
+    int uncovered;              // Buildings covered by no selected candidate
+    bool* selected;             // Whether each candidate is in the current solution
+    HeapEntry* heap;            // Candidates still to consider
+    int heap_size;              // Number of entries of the heap
+    ParetoSolution* solutions;  // Non-dominated solutions found so far
+    int num_solutions;          // Number of non-dominated solutions
+    int solutions_capacity;     // Allocated solutions
+} ParetoSearch;
+
+// Point of a nearest neighbour search
+typedef struct {
+    const char* id;             // Identifier of the entity
+    int x;                      // X coordinate (center of a building)
+    int y;                      // Y coordinate
+    int nearest;                // Position of the nearest other point, -1 if none
+    double distance;            // Distance to the nearest other point
+} NeighbourPoint;
+
+// Implicit k-d tree over points: the node of a range [lo, hi) of the order
+// is its middle position, which splits the rest of the range on one axis
+typedef struct {
+    const NeighbourPoint* points;   // Indexed points
+    int* order;                     // Positions of the points in tree order
+    unsigned char* axes;            // Split axis of each node (0 for x, 1 for y)
+} KdTree;
+
+// Point of a hull computation
+typedef struct {
+    double x;                   // X coordinate
+    double y;                   // Y coordinate
+} HullPoint;
+
+// Results published for one valid version of a watched file
+typedef struct CacheEntry {
+    struct CacheEntry* prev;    // More recently used entry
+    struct CacheEntry* next;    // Less recently used entry
+    unsigned long long hash;    // Content hash of the version
+    size_t size;                // Size of the results
+    char results[];             // Published results
+} CacheEntry;
+
+// Growable byte buffer of watch mode (file content, rendered results)
+typedef struct {
+    char* data;                 // Bytes held
+    size_t size;                // Number of bytes held
+    size_t capacity;            // Allocated bytes
+    MemSubsystem subsystem;     // Subsystem the allocation is accounted to
+} ByteBuffer;
+
+// Least recently used cache of the results of a watched file
+typedef struct {
+    CacheEntry* head;           // Most recently used entry
+    CacheEntry* tail;           // Least recently used entry
+    size_t bytes;               // Bytes held by the entries
+    size_t capacity;            // Maximum bytes held, 0 to disable the cache
+} ResultCache;
+
+// Memory arena chunk
+typedef struct ArenaChunk {
+    struct ArenaChunk* next;    // Next chunk of the arena
+    size_t size;                // Usable bytes in the chunk
+    size_t used;                // Bytes already handed out
+    unsigned char data[];       // Chunk storage
+} ArenaChunk;
+
+// Memory arena: bump allocator rewound as a whole between scenes
+typedef struct {
+    ArenaChunk* head;           // First chunk
+    ArenaChunk* current;        // Chunk allocations are taken from
+    MemSubsystem subsystem;     // Subsystem the chunks are accounted to
+} Arena;
+
+// Identifier index: open addressing hash table of entity positions
+typedef struct {
+    unsigned int* slots;        // Entity index + 1 per slot, 0 when empty
+    unsigned int capacity;      // Number of slots (power of two)
+    unsigned int count;         // Number of indexed entities
+} IdIndex;
+
+// Entry of a grid index: one item registered in one cell
+typedef struct {
+    long long cx;               // Cell column
+    long long cy;               // Cell row
+    int level;                  // Grid level of the cell
+    int item;                   // Index of the registered entity
+    int next;                   // Next entry of the same bucket
+} GridEntry;
+
+// Grid index: hierarchical hashed grid, cells of level L have size 2^L
+typedef struct {
+    int* buckets;                           // First entry of each bucket
+    unsigned int num_buckets;               // Number of buckets (power of two)
+    GridEntry* entries;                     // Entries array
+    unsigned int num_entries;               // Number of entries
+    unsigned int entries_capacity;          // Allocated entries
+    unsigned int level_counts[GRID_LEVELS]; // Number of items per level
+} GridIndex;
+
+// Box of cells of one depth of a grid walk, with the next cell to visit
+typedef struct {
+    long long cx0, cx1;         // Columns of the box
+    long long cy0, cy1;         // Rows of the box
+    long long cx, cy;           // Next cell to visit
+} GridWalkFrame;
+
+// Walk over the entries of a box of cells of one grid level, descending
+// from the non-empty summary cells only
+typedef struct {
+    int level;                                      // Grid level of the box
+    int depth;                                      // Depth of the current frame
+    int top;                                        // Depth the walk started from
+    int entry;                                      // Last returned entry
+    long long cx0, cx1, cy0, cy1;                   // Box at depth 0
+    GridWalkFrame frames[GRID_SUMMARY_DEPTHS + 1];  // Frame of each depth
+} GridWalk;
+
 // Scene structure
 typedef struct {
-    Building buildings[MAX_BUILDINGS];   // Buildings array
+    Building* buildings;                 // Buildings array
     unsigned int num_buildings;          // Number of buildings
-    Antenna antennas[MAX_ANTENNAS];      // Antennas array
+    unsigned int buildings_capacity;     // Allocated buildings
+    Antenna* antennas;                   // Antennas array
     unsigned int num_antennas;           // Number of antennas
+    unsigned int antennas_capacity;      // Allocated antennas
+    IdIndex building_ids;                // Building identifiers index
+    IdIndex antenna_ids;                 // Antenna identifiers index
+    GridIndex building_grid;             // Building footprints index
+    GridIndex antenna_positions;         // Antenna positions index
+    GridIndex antenna_spacing;           // Antenna positions by cells of the spacing level
+    Arena arena;                         // Storage of the entities arrays
+    Arena id_arena;                      // Storage of the identifier indexes
+    Arena grid_arena;                    // Storage of the grid indexes
 } Scene;
 
+// Weighting evaluated by a worker thread of the trade-off exploration
+typedef struct {
+    const Scene* scene;         // Current scene
+    const CoverSearch* search;  // Candidate sets, shared read-only by the workers
+    ParetoSearch* pareto;       // State of the worker, holding the cover it built
+    double lambda;              // Cost of one antenna on top of its radius
+} ParetoWorker;
+
+// Scene of a stream processed by a worker thread (--jobs)
+typedef struct {
+    Scene scene;                // Scene read for the worker, rewound for the next one
+    const char* subcommand;     // Subcommand to run on the scene
+    ByteBuffer results;         // Results, published once those of the scenes before are
+    FILE* output;               // Stream rendering into results
+    bool completed;             // Whether the subcommand succeeded
+    Stats stats;                // Counters of the worker, merged when the scene is published
+    double start;               // Time the scene started being read
+    double seconds;             // Time spent loading and processing the scene
+    int tid;                    // Trace thread of the worker
+    pthread_t thread;           // Worker thread
+    bool threaded;              // Whether the worker thread was started
+    bool pending;               // Whether the scene awaits publication
+} SceneJob;
+
 // --------------------------------------------------------
 // SECTION: FUNCTION PROTOTYPES AND DOCUMENTATION
 // --------------------------------------------------------
@@ -118,6 +534,103 @@ bool is_valid_integer(const char* str);
  */
 bool is_valid_positive_integer(const char* str);
 
+/**
+ * @brief Validates an azimuth string (integer between 0 and 359)
+ * @param str String to validate
+ * @return true if string represents a valid azimuth, false otherwise
+ */
+bool is_valid_azimuth(const char* str);
+
+/**
+ * @brief Validates a beamwidth string (integer between 1 and 360)
+ * @param str String to validate
+ * @return true if string represents a valid beamwidth, false otherwise
+ */
+bool is_valid_beamwidth(const char* str);
+
+/**
+ * @brief Parses the options preceding the subcommand
+ * @param argc Number of command-line arguments
+ * @param argv Command-line arguments
+ * @param options Output parameter for parsed options
+ * @return Position of the subcommand in argv, -1 if an option is invalid
+ */
+int parse_options(int argc, char* argv[], Options* options);
+
+/**
+ * @brief Parses the arguments following the subcommand into subcommand_args
+ * @param subcommand Subcommand the arguments are given to
+ * @param argc Number of arguments
+ * @param argv Arguments
+ * @return true if the arguments are valid for the subcommand, false otherwise
+ */
+bool parse_subcommand_args(const char* subcommand, int argc, char* argv[]);
+
+/**
+ * @brief Returns the current time of a monotonic clock
+ * @return Time in seconds
+ */
+double now_seconds(void);
+
+/**
+ * @brief Records the time spent on one scene in the latency histogram
+ * @param seconds Time spent loading and processing the scene
+ */
+void record_scene_latency(double seconds);
+
+/**
+ * @brief Adds the counters of a thread to those of another
+ * @param total Counters to add to
+ * @param part Counters to add
+ */
+void merge_stats(Stats* total, const Stats* part);
+
+/**
+ * @brief Prints one counter in Prometheus text format
+ * @param output Stream to print to
+ * @param name Name of the counter
+ * @param help Description of the counter
+ * @param value Value of the counter
+ */
+void print_counter(FILE* output, const char* name, const char* help,
+                   unsigned long long value);
+
+/**
+ * @brief Starts recording trace events
+ * @param path File the trace will be written to, created as an empty trace
+ * @return true if the file can be written, false otherwise
+ */
+bool trace_start(const char* path);
+
+/**
+ * @brief Records a trace event if tracing is enabled
+ * @param name Name of the phase, must outlive the trace
+ * @param phase 'B' when the phase begins, 'E' when it ends
+ */
+void trace_event(const char* name, char phase);
+
+/**
+ * @brief Appends the recorded events to the Chrome trace JSON file
+ *
+ * The events are then dropped from memory, so that watch mode, writing the
+ * trace after each version, only holds the events of one version. The file
+ * stays a complete trace between writes.
+ *
+ * @return true if the trace was written, false otherwise
+ */
+bool trace_write(void);
+
+/**
+ * @brief Frees the recorded trace events
+ */
+void trace_free(void);
+
+/**
+ * @brief Prints the statistics of the run in Prometheus text format
+ * @param output Stream to print to
+ */
+void print_stats(FILE* output);
+
 /**
  * @brief Checks if a subcommand is valid
  * @param subcommand String to check
@@ -125,6 +638,13 @@ bool is_valid_positive_integer(const char* str);
  */
 bool is_valid_subcommand(const char* subcommand);
 
+/**
+ * @brief Checks if a subcommand operates on a loaded scene
+ * @param subcommand String to check
+ * @return true if subcommand reads a scene, false otherwise
+ */
+bool is_scene_subcommand(const char* subcommand);
+
 /**
  * @brief Checks if a line is the begin scene marker
  * @param line String to check
@@ -162,11 +682,294 @@ void print_error_mandatory(void);
  */
 void print_error_unrecognized(const char* subcommand);
 
+/**
+ * @brief Prints error message when memory is exhausted
+ */
+void print_error_memory(void);
+
+/**
+ * @brief Prints error message for a wrong usage of the watch subcommand
+ */
+void print_error_watch_usage(void);
+
+/**
+ * @brief Prints error message for a file that cannot be opened
+ * @param path Path of the file
+ */
+void print_error_file(const char* path);
+
+/**
+ * @brief Prints error message for an unrecognized option
+ * @param option The invalid option
+ */
+void print_error_option(const char* option);
+
+/**
+ * @brief Prints error message for an option missing its argument
+ * @param option The incomplete option
+ */
+void print_error_option_argument(const char* option);
+
+/**
+ * @brief Prints error message for an invalid memory size
+ * @param size The invalid size
+ */
+void print_error_memory_size(const char* size);
+
+/**
+ * @brief Prints error message for an invalid minimum antenna spacing
+ * @param spacing The invalid spacing
+ */
+void print_error_spacing(const char* spacing);
+
+/**
+ * @brief Prints error message for an invalid number of jobs
+ * @param jobs The invalid number
+ */
+void print_error_jobs(const char* jobs);
+
+/**
+ * @brief Prints error message for an argument a subcommand does not accept
+ * @param subcommand The subcommand
+ * @param argument The invalid argument
+ */
+void print_error_subcommand_argument(const char* subcommand, const char* argument);
+
+/**
+ * @brief Prints error message for the optimize subcommand given no mode
+ */
+void print_error_optimize_mode(void);
+
+/**
+ * @brief Prints error message for an invalid value of a subcommand argument
+ * @param argument The argument
+ * @param value The invalid value
+ */
+void print_error_argument_value(const char* argument, const char* value);
+
 /**
  * @brief Prints help message with usage instructions
  */
 void print_help(void);
 
+/**
+ * @brief Allocates memory accounted to a subsystem
+ * @param size Number of bytes to allocate
+ * @param subsystem Subsystem the memory is accounted to
+ * @return Pointer to the allocated memory, NULL if memory is exhausted or
+ *         the memory budget would be exceeded
+ */
+void* kover_malloc(size_t size, MemSubsystem subsystem);
+
+/**
+ * @brief Resizes memory accounted to a subsystem
+ * @param ptr Memory to resize, may be NULL
+ * @param old_size Current size of the memory
+ * @param new_size Requested size
+ * @param subsystem Subsystem the memory is accounted to
+ * @return Pointer to the resized memory, NULL if memory is exhausted or the
+ *         memory budget would be exceeded (ptr is then left untouched)
+ */
+void* kover_realloc(void* ptr, size_t old_size, size_t new_size, MemSubsystem subsystem);
+
+/**
+ * @brief Frees memory accounted to a subsystem
+ * @param ptr Memory to free, may be NULL
+ * @param size Size of the memory
+ * @param subsystem Subsystem the memory is accounted to
+ */
+void kover_free(void* ptr, size_t size, MemSubsystem subsystem);
+
+/**
+ * @brief Parses a memory size with an optional K, M or G suffix
+ * @param str String to parse
+ * @param size Output parameter for the size in bytes
+ * @return true if the string is a valid memory size, false otherwise
+ */
+bool parse_memory_size(const char* str, size_t* size);
+
+/**
+ * @brief Allocates memory from an arena
+ * @param arena Arena to allocate from
+ * @param size Number of bytes to allocate
+ * @return Pointer to the allocated memory, NULL if memory is exhausted
+ */
+void* arena_alloc(Arena* arena, size_t size);
+
+/**
+ * @brief Releases every allocation of an arena while keeping its chunks
+ * @param arena Arena to rewind
+ */
+void arena_rewind(Arena* arena);
+
+/**
+ * @brief Frees all the chunks of an arena
+ * @param arena Arena to free
+ */
+void arena_free(Arena* arena);
+
+/**
+ * @brief Doubles the capacity of an array allocated in an arena
+ * @param arena Arena holding the array
+ * @param items Array to grow, updated to the new location
+ * @param capacity Current capacity, updated to the new capacity
+ * @param item_size Size of one array element
+ * @return true if the array was grown, false if memory is exhausted
+ */
+bool arena_grow_array(Arena* arena, void** items, unsigned int* capacity, size_t item_size);
+
+/**
+ * @brief Computes the hash of an identifier (FNV-1a)
+ * @param id Identifier to hash
+ * @return Hash of the identifier
+ */
+unsigned int hash_id(const char* id);
+
+/**
+ * @brief Finds an identifier in an index
+ *
+ * Indexed entities are stored in an array of elements of size stride, each
+ * element starting with its identifier.
+ *
+ * @param index Identifier index
+ * @param items Array of indexed entities
+ * @param stride Size of one entity
+ * @param id Identifier to look for
+ * @return Position of the entity in items, -1 if the identifier is unknown
+ */
+int id_index_find(const IdIndex* index, const void* items, size_t stride, const char* id);
+
+/**
+ * @brief Adds an entity to an identifier index
+ * @param index Identifier index
+ * @param arena Arena holding the index
+ * @param items Array of indexed entities
+ * @param stride Size of one entity
+ * @param item Position of the entity to add in items
+ * @return true if the entity was added, false if memory is exhausted
+ */
+bool id_index_insert(IdIndex* index, Arena* arena, const void* items, size_t stride,
+                     unsigned int item);
+
+/**
+ * @brief Computes the hash of a grid cell
+ * @param level Grid level of the cell
+ * @param cx Cell column
+ * @param cy Cell row
+ * @return Hash of the cell
+ */
+unsigned int hash_cell(int level, long long cx, long long cy);
+
+/**
+ * @brief Initializes an empty grid index
+ * @param grid Grid index to initialize
+ */
+void grid_index_init(GridIndex* grid);
+
+/**
+ * @brief Registers an item in a cell of a grid index
+ * @param grid Grid index
+ * @param arena Arena holding the index
+ * @param level Grid level of the cell
+ * @param cx Cell column
+ * @param cy Cell row
+ * @param item Item to register
+ * @return true if the item was registered, false if memory is exhausted
+ */
+bool grid_index_insert(GridIndex* grid, Arena* arena, int level, long long cx,
+                       long long cy, int item);
+
+/**
+ * @brief Skips the entries of a bucket chain that belong to other cells
+ * @param grid Grid index
+ * @param entry First entry to consider
+ * @param level Grid level of the cell
+ * @param cx Cell column
+ * @param cy Cell row
+ * @return First entry of the cell from entry on, NO_ENTRY if there is none
+ */
+int grid_cell_skip(const GridIndex* grid, int entry, int level, long long cx,
+                   long long cy);
+
+/**
+ * @brief Finds the first entry of a cell in a grid index
+ * @param grid Grid index
+ * @param level Grid level of the cell
+ * @param cx Cell column
+ * @param cy Cell row
+ * @return First entry registered in the cell, NO_ENTRY if the cell is empty
+ */
+int grid_cell_first(const GridIndex* grid, int level, long long cx, long long cy);
+
+/**
+ * @brief Finds the next entry of the same cell in a grid index
+ * @param grid Grid index
+ * @param entry Current entry
+ * @return Next entry registered in the cell, NO_ENTRY if there is none
+ */
+int grid_cell_next(const GridIndex* grid, int entry);
+
+/**
+ * @brief Computes the grid key of a summary cell
+ * @param level Grid level of the summarized cells
+ * @param depth Depth of the summary (0 for the cells themselves)
+ * @return Level under which the summary cells are registered
+ */
+int grid_summary_level(int level, int depth);
+
+/**
+ * @brief Registers a cell in the summary cells above it
+ *
+ * Summary cells only record that some cell below them is occupied, so that
+ * walks over large boxes skip the empty regions. Registration stops at the
+ * first summary cell already present, since all its ancestors are too.
+ *
+ * @param grid Grid index
+ * @param arena Arena holding the index
+ * @param level Grid level of the cell
+ * @param cx Cell column
+ * @param cy Cell row
+ * @return true if the cell was registered, false if memory is exhausted
+ */
+bool grid_summary_insert(GridIndex* grid, Arena* arena, int level, long long cx,
+                         long long cy);
+
+/**
+ * @brief Starts a walk over a box of cells of one grid level
+ *
+ * The walk starts from the shallowest depth where the box spans at most
+ * GRID_WALK_CELLS summary cells, so its cost depends on the occupied cells
+ * near the box rather than on the size of the box or of the level.
+ *
+ * @param walk Walk to start
+ * @param level Grid level of the box
+ * @param cx0 First column of the box
+ * @param cx1 Last column of the box
+ * @param cy0 First row of the box
+ * @param cy1 Last row of the box
+ */
+void grid_walk_start(GridWalk* walk, int level, long long cx0, long long cx1,
+                     long long cy0, long long cy1);
+
+/**
+ * @brief Finds the next entry of a walk
+ * @param grid Grid index with summary cells
+ * @param walk Walk in progress
+ * @return Next entry registered in a cell of the box, NO_ENTRY at the end
+ */
+int grid_walk_next(const GridIndex* grid, GridWalk* walk);
+
+/**
+ * @brief Computes the grid level where a building is indexed
+ *
+ * The level is the smallest one whose cells are at least as large as the
+ * building, so that a building spans at most 2 x 2 cells of its level.
+ *
+ * @param b Building to index
+ * @return Grid level of the building
+ */
+int building_level(const Building* b);
+
 /**
  * @brief Checks if two buildings overlap
  * @param b1 First building
@@ -262,24 +1065,33 @@ void construct_building(Building* building, const char* id, const char* x_str,
  * @param x_str X coordinate string
  * @param y_str Y coordinate string
  * @param r_str Radius string
+ * @param az_str Azimuth string (empty for an omnidirectional antenna)
+ * @param bw_str Beamwidth string (empty for an omnidirectional antenna)
  * @param line_num Line number for error reporting
  * @return true if all arguments are valid, false otherwise
  */
 bool validate_antenna_args(const char* id, const char* x_str, const char* y_str,
-                         const char* r_str, int line_num);
+                         const char* r_str, const char* az_str,
+                         const char* bw_str, int line_num);
 
 /**
  * @brief Extracts antenna arguments from a line
+ *
+ * The azimuth and beamwidth are optional: they are set to empty strings
+ * when the line only has the basic 'antenna ID X Y R' form.
+ *
  * @param line Input line
  * @param id Output for antenna ID
  * @param x_str Output for x coordinate string
  * @param y_str Output for y coordinate string
  * @param r_str Output for radius string
+ * @param az_str Output for azimuth string
+ * @param bw_str Output for beamwidth string
  * @param line_num Line number for error reporting
  * @return true if extraction successful, false otherwise
  */
 bool extract_antenna_args(const char* line, char* id, char* x_str, char* y_str,
-                        char* r_str, int line_num);
+                        char* r_str, char* az_str, char* bw_str, int line_num);
 
 /**
  * @brief Constructs an Antenna structure from validated arguments
@@ -288,48 +1100,233 @@ bool extract_antenna_args(const char* line, char* id, char* x_str, char* y_str,
  * @param x_str X coordinate string
  * @param y_str Y coordinate string
  * @param r_str Radius string
+ * @param az_str Azimuth string (empty for an omnidirectional antenna)
+ * @param bw_str Beamwidth string (empty for an omnidirectional antenna)
  */
 void construct_antenna(Antenna* antenna, const char* id, const char* x_str,
-                      const char* y_str, const char* r_str);
+                      const char* y_str, const char* r_str,
+                      const char* az_str, const char* bw_str);
 
 /**
- * @brief Prints buildings in sorted order
- * @param scene Scene containing buildings
+ * @brief Checks if an antenna covers its whole disk
+ * @param a Antenna to check
+ * @return true if the antenna is omnidirectional, false if it is a sector
  */
-void print_sorted_buildings(const Scene* scene);
+bool is_omnidirectional(const Antenna* a);
 
 /**
- * @brief Prints antennas in sorted order
- * @param scene Scene containing antennas
+ * @brief Checks if a direction lies within the sector of an antenna
+ * @param a Antenna whose sector is considered
+ * @param angle Direction in degrees, clockwise from north
+ * @return true if the direction is inside the sector, false otherwise
  */
-void print_sorted_antennas(const Scene* scene);
+bool sector_contains_angle(const Antenna* a, int angle);
 
 /**
- * @brief Initializes an empty scene
- * @param scene Scene to initialize
+ * @brief Rounds a coordinate that is an integer up to floating-point noise
+ * @param v Value to snap
+ * @return The nearest integer if v is within 1e-9 of it, v otherwise
  */
-void init_scene(Scene* scene);
+double snap_to_integer(double v);
 
 /**
- * @brief Processes a building line and adds to scene
- * @param scene Current scene
- * @param line Line to process
- * @param line_num Current line number for error reporting
- * @return true if processing successful, false otherwise
+ * @brief Extends the bounds of an antenna to a point of its circle
+ * @param a Antenna whose bounds are extended
+ * @param angle Direction of the point in degrees, clockwise from north
  */
-bool process_building(Scene* scene, const char* line, int line_num);
+void extend_bounds_on_circle(Antenna* a, double angle);
 
 /**
- * @brief Processes an antenna line and adds to scene
- * @param scene Current scene
- * @param line Line to process
- * @param line_num Current line number for error reporting
- * @return true if processing successful, false otherwise
+ * @brief Precomputes the bounding box of the area covered by an antenna
+ *
+ * The box of a sector is derived from its apex, the two ends of its arc and
+ * the cardinal points of the circle falling inside the sector. Coordinates
+ * are rounded outwards so that the box always encloses the sector.
+ *
+ * @param a Antenna whose bounds are updated
  */
-bool process_antenna(Scene* scene, const char* line, int line_num);
+void compute_antenna_bounds(Antenna* a);
 
 /**
- * @brief Processes any input line
+ * @brief Prints buildings in sorted order
+ * @param scene Scene containing buildings
+ * @param output Stream to print to
+ * @return false if memory is exhausted, true otherwise
+ */
+bool print_sorted_buildings(const Scene* scene, FILE* output);
+
+/**
+ * @brief Prints antennas in sorted order
+ * @param scene Scene containing antennas
+ * @param output Stream to print to
+ * @return false if memory is exhausted, true otherwise
+ */
+bool print_sorted_antennas(const Scene* scene, FILE* output);
+
+/**
+ * @brief Reference version of print_sorted_buildings, sorting the identifiers
+ *        and looking each building up by a linear search
+ * @param scene Scene containing buildings
+ * @param output Stream to print to
+ * @return false if memory is exhausted, true otherwise
+ */
+bool reference_print_sorted_buildings(const Scene* scene, FILE* output);
+
+/**
+ * @brief Reference version of print_sorted_antennas, sorting the identifiers
+ *        and looking each antenna up by a linear search
+ * @param scene Scene containing antennas
+ * @param output Stream to print to
+ * @return false if memory is exhausted, true otherwise
+ */
+bool reference_print_sorted_antennas(const Scene* scene, FILE* output);
+
+/**
+ * @brief Initializes an empty scene
+ * @param scene Scene to initialize
+ */
+void init_scene(Scene* scene);
+
+/**
+ * @brief Empties a scene by rewinding its arena, keeping its memory
+ * @param scene Scene to reset
+ */
+void reset_scene(Scene* scene);
+
+/**
+ * @brief Frees the memory held by a scene
+ * @param scene Scene to free
+ */
+void free_scene(Scene* scene);
+
+/**
+ * @brief Finds the first building of a scene overlapping a building
+ * @param scene Current scene
+ * @param b Building to check
+ * @return Smallest position of an overlapping building, -1 if there is none
+ */
+int find_overlapping_building(const Scene* scene, const Building* b);
+
+/**
+ * @brief Finds an antenna of a scene placed at a given position
+ * @param scene Current scene
+ * @param x X coordinate
+ * @param y Y coordinate
+ * @return Position of the antenna, -1 if there is none
+ */
+int find_antenna_at(const Scene* scene, int x, int y);
+
+/**
+ * @brief Finds the first antenna of a scene closer to an antenna than the
+ *        minimum spacing
+ *
+ * With cells at least as large as the spacing, a closer antenna lies in the
+ * cell of the antenna or in one of the 8 cells around it.
+ *
+ * @param scene Current scene
+ * @param a Antenna to check
+ * @return Smallest position of a too close antenna, -1 if there is none
+ */
+int find_close_antenna(const Scene* scene, const Antenna* a);
+
+/**
+ * @brief Finds the building of a scene whose rectangle contains a point
+ *
+ * Buildings do not overlap, so a point is in one building at most, or on
+ * the shared edges of up to 4 of them, in which case the first one is taken.
+ *
+ * @param scene Current scene
+ * @param x X coordinate
+ * @param y Y coordinate
+ * @return Smallest position of a building containing the point, -1 if none
+ */
+int find_building_at(const Scene* scene, int x, int y);
+
+/**
+ * @brief Reference version of find_overlapping_building, scanning every building
+ * @param scene Current scene
+ * @param b Building to check
+ * @return Smallest position of an overlapping building, -1 if there is none
+ */
+int reference_find_overlapping_building(const Scene* scene, const Building* b);
+
+/**
+ * @brief Reference version of find_antenna_at, scanning every antenna
+ * @param scene Current scene
+ * @param x X coordinate
+ * @param y Y coordinate
+ * @return Smallest position of an antenna at (x, y), -1 if there is none
+ */
+int reference_find_antenna_at(const Scene* scene, int x, int y);
+
+/**
+ * @brief Reference version of find_close_antenna, scanning every antenna
+ * @param scene Current scene
+ * @param a Antenna to check
+ * @return Smallest position of a too close antenna, -1 if there is none
+ */
+int reference_find_close_antenna(const Scene* scene, const Antenna* a);
+
+/**
+ * @brief Checks if two antennas are closer than the minimum spacing
+ * @param a1 First antenna
+ * @param a2 Second antenna
+ * @return true if the distance between the antennas is below the spacing
+ */
+bool antennas_too_close(const Antenna* a1, const Antenna* a2);
+
+/**
+ * @brief Reference version of is_duplicate_building_id, scanning every building
+ * @param scene Current scene
+ * @param id ID to check
+ * @return true if ID already exists, false otherwise
+ */
+bool reference_is_duplicate_building_id(const Scene* scene, const char* id);
+
+/**
+ * @brief Reference version of is_duplicate_antenna_id, scanning every antenna
+ * @param scene Current scene
+ * @param id ID to check
+ * @return true if ID already exists, false otherwise
+ */
+bool reference_is_duplicate_antenna_id(const Scene* scene, const char* id);
+
+/**
+ * @brief Appends a validated building to a scene and its indexes
+ * @param scene Current scene
+ * @param b Building to add
+ * @return true if the building was added, false if memory is exhausted
+ */
+bool add_building(Scene* scene, const Building* b);
+
+/**
+ * @brief Appends a validated antenna to a scene and its indexes
+ * @param scene Current scene
+ * @param a Antenna to add
+ * @return true if the antenna was added, false if memory is exhausted
+ */
+bool add_antenna(Scene* scene, const Antenna* a);
+
+/**
+ * @brief Processes a building line and adds to scene
+ * @param scene Current scene
+ * @param line Line to process
+ * @param line_num Current line number for error reporting
+ * @return true if processing successful, false otherwise
+ */
+bool process_building(Scene* scene, const char* line, int line_num);
+
+/**
+ * @brief Processes an antenna line and adds to scene
+ * @param scene Current scene
+ * @param line Line to process
+ * @param line_num Current line number for error reporting
+ * @return true if processing successful, false otherwise
+ */
+bool process_antenna(Scene* scene, const char* line, int line_num);
+
+/**
+ * @brief Processes any input line
  * @param scene Current scene
  * @param line Line to process
  * @param line_num Current line number for error reporting
@@ -338,11 +1335,227 @@ bool process_antenna(Scene* scene, const char* line, int line_num);
 bool process_line(Scene* scene, char* line, int line_num);
 
 /**
- * @brief Reads complete scene from stdin
+ * @brief Reads one line from a stream, without its newline
+ * @param input Stream to read from
+ * @param line Output buffer of MAX_LINE_LENGTH characters
+ * @param line_num Number of lines read so far, incremented
+ * @return true if a line was read, false at the end of the stream
+ */
+bool read_line(FILE* input, char* line, int* line_num);
+
+/**
+ * @brief Reads the next complete scene from a stream
  * @param scene Output parameter for read scene
+ * @param first_line First line of the scene, already read
+ * @param input Stream to read the other lines from
+ * @param line_num Number of lines read so far, updated with the scene lines
  * @return true if reading successful, false otherwise
  */
-bool read_scene(Scene* scene);
+bool read_scene(Scene* scene, const char* first_line, FILE* input, int* line_num);
+
+/**
+ * @brief Reads the first line of the next scene of a stream
+ *
+ * Lines holding only blanks between scenes, or after the last one, are
+ * skipped.
+ *
+ * @param input Stream to read from
+ * @param line Output buffer of MAX_LINE_LENGTH characters
+ * @param line_num Number of lines read so far, updated with the lines read
+ * @return true if another scene follows, false at the end of the stream
+ */
+bool read_next_scene(FILE* input, char* line, int* line_num);
+
+/**
+ * @brief Runs a subcommand on every scene of a stream
+ * @param subcommand Subcommand to run
+ * @param input Stream of scenes
+ * @param output Stream to print results to
+ * @param jobs Scenes processed at once (see process_stream_parallel)
+ * @return SUCCESS if every scene was valid and fully processed, ERROR otherwise
+ */
+int process_stream(const char* subcommand, FILE* input, FILE* output, int jobs);
+
+/**
+ * @brief Runs a subcommand on the scenes of a stream in worker threads
+ *
+ * Scenes are still read and validated in turn by the calling thread, each
+ * one then being handed to a worker rendering its results into a buffer.
+ * Up to jobs scenes are held at once; before a slot is reused, the results
+ * of its scene are published, so they come out in the order of the stream.
+ * After a failed scene, the results of the scenes following it are dropped.
+ * An invalid scene is reported as soon as it is read, possibly before the
+ * results of the scenes preceding it.
+ *
+ * @param subcommand Subcommand to run
+ * @param input Stream of scenes
+ * @param output Stream to print results to
+ * @param jobs Scenes processed at once, at least 2
+ * @return SUCCESS if every scene was valid and fully processed, ERROR otherwise
+ */
+int process_stream_parallel(const char* subcommand, FILE* input, FILE* output, int jobs);
+
+/**
+ * @brief Runs the subcommand of a scene job, on the current thread
+ * @param job Scene job, whose results and completion are updated
+ */
+void scene_job_run(SceneJob* job);
+
+/**
+ * @brief Runs the subcommand of a scene job (pthread entry point)
+ * @param arg SceneJob to run, whose counters are saved before the thread ends
+ * @return NULL
+ */
+void* scene_job_thread(void* arg);
+
+/**
+ * @brief Starts the subcommand of a scene job in a worker thread
+ *
+ * The subcommand runs on the current thread if no thread can be started.
+ *
+ * @param job Scene job whose scene was read
+ * @return true on success, false if memory is exhausted
+ */
+bool scene_job_start(SceneJob* job);
+
+/**
+ * @brief Waits for a scene job and publishes its results
+ * @param job Pending scene job
+ * @param output Stream to print the results to, NULL to drop them
+ * @return true if the subcommand succeeded and its results were rendered
+ */
+bool scene_job_finish(SceneJob* job, FILE* output);
+
+/**
+ * @brief Makes room for more bytes in a byte buffer (capacity doubled)
+ * @param buffer Byte buffer
+ * @param extra Number of bytes that must fit after the ones held
+ * @return true on success, false if memory is exhausted
+ */
+bool byte_buffer_reserve(ByteBuffer* buffer, size_t extra);
+
+/**
+ * @brief Appends data to a byte buffer (fopencookie write function)
+ * @param cookie Byte buffer
+ * @param data Data to append
+ * @param size Number of bytes to append
+ * @return Number of bytes appended, 0 if memory is exhausted
+ */
+ssize_t byte_buffer_write(void* cookie, const char* data, size_t size);
+
+/**
+ * @brief Opens a stream rendering into a byte buffer
+ *
+ * Unlike open_memstream, the buffer is allocated through the memory
+ * accounting, so that it counts towards --max-memory. The stream is
+ * unbuffered, so that it holds no memory of its own.
+ *
+ * @param buffer Empty byte buffer, freed by the caller once the stream is closed
+ * @return Stream writing to the buffer, NULL if memory is exhausted
+ */
+FILE* byte_buffer_open(ByteBuffer* buffer);
+
+/**
+ * @brief Reads the whole content of a file into a byte buffer
+ *
+ * The content of a version is read once: the same bytes are hashed for the
+ * result cache and parsed, so a file rewritten in between cannot get the
+ * results of another content.
+ *
+ * @param path File to read
+ * @param content Empty byte buffer, freed by the caller
+ * @return true if the file was read, false if it cannot be opened or memory
+ *         is exhausted (the error is then reported)
+ */
+bool read_file(const char* path, ByteBuffer* content);
+
+/**
+ * @brief Evaluates a new version of a watched file
+ *
+ * Results are rendered into a private buffer and only published on stdout
+ * once the whole file has been validated. An invalid version, or one whose
+ * processing ran out of memory, reports its errors and publishes nothing, so
+ * the last published results remain the ones of the last valid version.
+ *
+ * @param subcommand Subcommand to run
+ * @param input Content of the new version
+ * @param cache Cache the results of a valid version are stored in
+ * @param hash Content hash of the new version
+ * @param jobs Scenes processed at once
+ * @return true if the version was valid and published, false otherwise
+ */
+bool publish_version(const char* subcommand, FILE* input, ResultCache* cache,
+                     unsigned long long hash, int jobs);
+
+/**
+ * @brief Looks up the results of a version in a result cache
+ *
+ * A found entry becomes the most recently used one. The key is the content
+ * hash, so a modified file never matches the results of its old content.
+ *
+ * @param cache Result cache
+ * @param hash Content hash of the version
+ * @return Cached entry, NULL if the version is not cached
+ */
+CacheEntry* cache_find(ResultCache* cache, unsigned long long hash);
+
+/**
+ * @brief Stores the results of a version in a result cache
+ *
+ * Least recently used entries are evicted until the new entry fits in the
+ * capacity. Results larger than the whole capacity are not cached.
+ *
+ * @param cache Result cache
+ * @param hash Content hash of the version
+ * @param results Published results
+ * @param size Size of the results
+ */
+void cache_store(ResultCache* cache, unsigned long long hash, const char* results,
+                 size_t size);
+
+/**
+ * @brief Removes an entry from the recency list of a result cache
+ * @param cache Result cache
+ * @param entry Entry to remove
+ */
+void cache_unlink(ResultCache* cache, CacheEntry* entry);
+
+/**
+ * @brief Frees all the entries of a result cache
+ * @param cache Result cache
+ */
+void cache_free(ResultCache* cache);
+
+/**
+ * @brief Computes the hash of a content (FNV-1a)
+ * @param data Content to hash
+ * @param size Number of bytes of the content
+ * @return Hash of the content
+ */
+unsigned long long hash_bytes(const char* data, size_t size);
+
+/**
+ * @brief Runs a subcommand on a file whenever its content is modified
+ *
+ * The parent directory is watched with inotify so that editors replacing
+ * the file on save are followed. A change is only processed if the content
+ * hash differs from the one of the last evaluation.
+ *
+ * @param subcommand Subcommand to run
+ * @param path File to watch
+ * @param options Command-line options
+ * @return ERROR if the file cannot be watched, does not return otherwise
+ */
+int watch_file(const char* subcommand, const char* path, const Options* options);
+
+/**
+ * @brief Runs a subcommand on a loaded scene
+ * @param subcommand Subcommand to run
+ * @param scene Loaded scene
+ * @param output Stream to print to
+ * @return false if memory is exhausted, true otherwise
+ */
+bool run_subcommand(const char* subcommand, const Scene* scene, FILE* output);
 
 /**
  * @brief Computes bounding box for scene
@@ -355,571 +1568,3868 @@ bool read_scene(Scene* scene);
 void compute_bounding_box(const Scene* scene, int* min_x, int* max_x, int* min_y, int* max_y);
 
 /**
- * @brief Prints scene bounding box
- * @param scene Scene to analyze
+ * @brief Checks if a point lies within the area covered by an antenna
+ * @param a Antenna to check
+ * @param px X coordinate of the point
+ * @param py Y coordinate of the point
+ * @return true if the point is within range and inside the sector
  */
-void print_bounding_box(const Scene* scene);
+bool antenna_covers_point(const Antenna* a, long long px, long long py);
 
 /**
- * @brief Prints scene summary
- * @param scene Scene to summarize
+ * @brief Checks if a segment enters the blind cone of a sector wider than 180 degrees
+ * @param a Antenna whose blind cone (outside its beam) is considered
+ * @param px X coordinate of the first end
+ * @param py Y coordinate of the first end
+ * @param qx X coordinate of the second end
+ * @param qy Y coordinate of the second end
+ * @return true if a point of the segment lies strictly inside the blind cone
  */
-void print_summary(const Scene* scene);
+bool segment_enters_blind_cone(const Antenna* a, double px, double py, double qx, double qy);
 
 /**
- * @brief Prints building details
- * @param b Building to print
+ * @brief Checks if an antenna fully covers a building
+ *
+ * The disk and a sector up to 180 degrees are convex, so they contain the
+ * rectangle as soon as they contain its corners. A wider sector must also
+ * keep the sides of the rectangle out of its blind cone.
+ *
+ * @param a Antenna to check
+ * @param b Building to check
+ * @return true if every point of the building is covered by the antenna
  */
-void print_building(const Building* b);
+bool antenna_covers_building(const Antenna* a, const Building* b);
 
 /**
- * @brief Prints antenna details
- * @param a Antenna to print
+ * @brief Finds the buildings of a scene intersecting a box
+ * @param scene Current scene
+ * @param min_x Minimum x coordinate of the box
+ * @param max_x Maximum x coordinate of the box
+ * @param min_y Minimum y coordinate of the box
+ * @param max_y Maximum y coordinate of the box
+ * @param found Output positions of the buildings, large enough for all of them
+ * @return Number of buildings found, each reported once
  */
-void print_antenna(const Antenna* a);
+int find_buildings_in_box(const Scene* scene, long long min_x, long long max_x,
+                          long long min_y, long long max_y, int* found);
 
 /**
- * @brief Comparison function for sorting IDs
- * @param a First ID to compare
- * @param b Second ID to compare
+ * @brief Gets one coordinate of a point
+ * @param p Point
+ * @param axis 0 for x, 1 for y
+ * @return Coordinate of the point on the axis
+ */
+long long point_coordinate(const NeighbourPoint* p, int axis);
+
+/**
+ * @brief Moves the k-th point of a range of a k-d tree order on an axis to
+ *        position k, smaller ones before and larger ones after it
+ *
+ * Three-way partitions keep the selection linear on repeated coordinates.
+ *
+ * @param tree K-d tree being built
+ * @param lo First position of the range
+ * @param hi Position after the range
+ * @param k Position to select
+ * @param axis Axis to compare on
+ */
+void kd_tree_select(KdTree* tree, int lo, int hi, int k, int axis);
+
+/**
+ * @brief Builds the k-d tree of a range of the order, each node splitting its
+ *        range at the median on the axis where the range is the widest
+ * @param tree K-d tree being built
+ * @param lo First position of the range
+ * @param hi Position after the range
+ */
+void kd_tree_build(KdTree* tree, int lo, int hi);
+
+/**
+ * @brief Searches a range of a k-d tree for a point nearer than the best one
+ *
+ * The side of a node holding the point is searched first, the other side
+ * only if its splitting line is not farther than the best distance so far.
+ * Ties go to the lowest position.
+ *
+ * @param tree K-d tree
+ * @param lo First position of the range
+ * @param hi Position after the range
+ * @param i Position of the point whose neighbour is searched
+ * @param best Position of the nearest point so far, -1 if none
+ * @param best_d2 Squared distance of the nearest point so far
+ */
+void kd_tree_nearest(const KdTree* tree, int lo, int hi, int i, int* best,
+                     long long* best_d2);
+
+/**
+ * @brief Finds the nearest other point of each point
+ *
+ * The points are indexed in a k-d tree, whose median splits adapt to the
+ * local density: clustered points and far outliers cost a logarithmic number
+ * of nodes per query, as uniform points do. Ties go to the lowest position.
+ *
+ * @param points Points to search, nearest and distance are set
+ * @param n Number of points
+ * @return true on success, false if memory is exhausted
+ */
+bool find_nearest_neighbours(NeighbourPoint* points, int n);
+
+/**
+ * @brief Comparison function for sorting hull points by x, then y
+ * @param a Pointer to the first point
+ * @param b Pointer to the second point
  * @return Negative if a<b, 0 if equal, positive if a>b
  */
-int compare_ids(const void* a, const void* b);
+int compare_hull_points(const void* a, const void* b);
 
 /**
- * @brief Prints detailed scene description
- * @param scene Scene to describe
+ * @brief Computes the cross product of the vectors o->a and o->b
+ * @param o Origin of the vectors
+ * @param a End of the first vector
+ * @param b End of the second vector
+ * @return Positive if o, a, b turn counterclockwise, negative if clockwise
  */
-void print_description(const Scene* scene);
+double cross_product(const HullPoint* o, const HullPoint* a, const HullPoint* b);
 
-// --------------------------------------------------------
-// SECTION: UTILITY AND VALIDATION FUNCTIONS
-// --------------------------------------------------------
+/**
+ * @brief Collects the building corners and the vertices of the polygons
+ *        circumscribed to the antenna disks
+ *
+ * A sector contributes its apex, the two ends of its arc and the vertices
+ * of the circumscribed polygon lying on the arc (its share of the sides,
+ * at least one), so that the hull encloses the sector and nothing behind it.
+ *
+ * @param scene Current scene
+ * @param sides Sides of the polygons replacing the disks
+ * @param points Output points, 4 per building and up to sides + 3 per antenna
+ * @return Number of points
+ */
+int collect_hull_points(const Scene* scene, int sides, HullPoint* points);
+
+/**
+ * @brief Projects a point on a direction
+ * @param p Point to project
+ * @param origin Origin of the projection
+ * @param dx X component of the direction (unit vector)
+ * @param dy Y component of the direction
+ * @return Signed distance from the origin along the direction
+ */
+double project_point(const HullPoint* p, const HullPoint* origin, double dx, double dy);
+
+/**
+ * @brief Checks if a point lies outside a circle
+ * @param p Point to check
+ * @param center Center of the circle
+ * @param radius Radius of the circle
+ * @return true if the point is outside the circle (up to rounding)
+ */
+bool outside_circle(const HullPoint* p, const HullPoint* center, double radius);
+
+/**
+ * @brief Computes the convex hull of points (Andrew's monotone chain)
+ * @param points Points, sorted in place
+ * @param n Number of points
+ * @param hull Output hull vertices counterclockwise, from the lowest x (then
+ *             y), without collinear vertices; room for n + 1 points
+ * @return Number of hull vertices
+ */
+int convex_hull(HullPoint* points, int n, HullPoint* hull);
+
+/**
+ * @brief Computes the minimum area bounding rectangle of a convex polygon
+ *
+ * The rectangle has a side along an edge of the polygon. Rotating calipers
+ * follow the vertices farthest along the edge, across it and against it,
+ * each moving forward only, so that all the edges are tried in O(h).
+ *
+ * @param hull Convex polygon, counterclockwise, at least 3 vertices
+ * @param h Number of vertices
+ * @param corners Output corners of the rectangle, counterclockwise
+ * @return Area of the rectangle
+ */
+double minimum_area_rectangle(const HullPoint* hull, int h, HullPoint corners[4]);
+
+/**
+ * @brief Computes the minimum enclosing circle of points (Welzl's algorithm,
+ *        iterative form after a deterministic shuffle, expected O(n))
+ * @param points Points, shuffled in place
+ * @param n Number of points, at least 1
+ * @param center Output center of the circle
+ * @return Radius of the circle
+ */
+double minimum_enclosing_circle(HullPoint* points, int n, HullPoint* center);
+
+/**
+ * @brief Builds the candidate sets of the minimum cover solver
+ *
+ * Each antenna gets the list of the buildings it fully covers. Antennas
+ * covering nothing, or a subset of what another antenna covers, can never
+ * be needed in a minimum cover and are dropped. A superset of an antenna
+ * also covers its least covered building, so only the antennas covering
+ * that building are checked, and once COVER_DOMINANCE_WORK buildings have
+ * been visited the remaining antennas are kept unchecked.
+ *
+ * When the radii matter, an antenna is only dropped for another one whose
+ * radius is not larger.
+ *
+ * @param scene Current scene
+ * @param search Search state to initialize
+ * @param weighted Whether the radii of the antennas are minimized too
+ * @param dense Whether to build the bitsets of the exact search, which are
+ *              left NULL anyway beyond COVER_DENSE_WORDS words
+ * @param uncoverable Output position of a building no antenna covers, -1 if none
+ * @return true if the state was built, false if memory is exhausted
+ */
+bool cover_search_init(const Scene* scene, CoverSearch* search, bool weighted, bool dense,
+                       int* uncoverable);
+
+/**
+ * @brief Frees the memory of a minimum cover search
+ * @param search Search state to free
+ */
+void cover_search_free(CoverSearch* search);
+
+/**
+ * @brief Computes a greedy cover, the initial upper bound of the search
+ * @param search Search state, best is set to the greedy cover
+ */
+void cover_greedy(CoverSearch* search);
+
+/**
+ * @brief Explores the covers extending the current one (branch and bound)
+ *
+ * The branching building is the uncovered one with the fewest candidates,
+ * tried in decreasing order of newly covered buildings. Once the branch of
+ * a candidate is explored, the following branches exclude it. A branch is cut as
+ * soon as a lower bound on the antennas still needed cannot lead to a
+ * smaller cover than the best one: the uncovered buildings divided by the
+ * best possible gain, or the number of uncovered buildings that pairwise
+ * share no candidate. Once nodes_left nodes are explored, the search stops
+ * and best holds the smallest cover found so far.
+ *
+ * @param search Search state
+ * @param depth Number of candidates in the current cover
+ */
+void cover_branch(CoverSearch* search, int depth);
+
+/**
+ * @brief Counts the buildings of a bitset also in another one
+ * @param a First bitset
+ * @param b Second bitset
+ * @param words Number of words of the bitsets
+ * @return Number of bits set in both bitsets
+ */
+int bitset_and_count(const uint64_t* a, const uint64_t* b, int words);
+
+/**
+ * @brief Pushes a candidate on a max-heap
+ * @param heap Heap entries
+ * @param size Number of entries, incremented
+ * @param priority Priority of the candidate
+ * @param item Candidate to push
+ */
+void heap_push(HeapEntry* heap, int* size, double priority, int item);
+
+/**
+ * @brief Pops the candidate of highest priority (lowest candidate on ties)
+ * @param heap Heap entries, not empty
+ * @param size Number of entries, decremented
+ * @return Popped entry
+ */
+HeapEntry heap_pop(HeapEntry* heap, int* size);
+
+/**
+ * @brief Allocates the state of a trade-off exploration
+ * @param search Candidate sets of the scene (weighted dominance)
+ * @param pareto State to initialize
+ * @return true if the state was allocated, false if memory is exhausted
+ */
+bool pareto_search_init(const CoverSearch* search, ParetoSearch* pareto);
+
+/**
+ * @brief Frees the state of a trade-off exploration and its solutions
+ * @param search Candidate sets the state was built for
+ * @param pareto State to free
+ */
+void pareto_search_free(const CoverSearch* search, ParetoSearch* pareto);
+
+/**
+ * @brief Adds a candidate to the current solution
+ *
+ * Coverage counts and gains are updated incrementally: only the buildings
+ * of the candidate, and the candidates of the buildings it newly covers,
+ * are visited.
+ *
+ * @param search Candidate sets
+ * @param pareto Exploration state
+ * @param candidate Candidate to add
+ */
+void pareto_select(const CoverSearch* search, ParetoSearch* pareto, int candidate);
+
+/**
+ * @brief Removes a candidate from the current solution (inverse of pareto_select)
+ * @param search Candidate sets
+ * @param pareto Exploration state
+ * @param candidate Candidate to remove
+ */
+void pareto_deselect(const CoverSearch* search, ParetoSearch* pareto, int candidate);
+
+/**
+ * @brief Checks if every building of a candidate is covered by another selected one
+ * @param search Candidate sets
+ * @param pareto Exploration state
+ * @param candidate Selected candidate to check
+ * @return true if the candidate can be removed from the current solution
+ */
+bool pareto_is_redundant(const CoverSearch* search, const ParetoSearch* pareto,
+                         int candidate);
+
+/**
+ * @brief Builds a cover for one weighting of the antennas against their radii
+ *
+ * Candidates are taken greedily by decreasing newly covered buildings per
+ * cost, the cost of an antenna being its radius plus lambda (lazy
+ * evaluation: gains only decrease, so a popped candidate whose priority is
+ * still the highest is chosen). Redundant antennas are then removed, largest
+ * radius first.
+ *
+ * @param scene Current scene
+ * @param search Candidate sets
+ * @param pareto Exploration state, holding the cover built
+ * @param lambda Cost of one antenna on top of its radius
+ */
+void pareto_greedy(const Scene* scene, const CoverSearch* search, ParetoSearch* pareto,
+                   double lambda);
+
+/**
+ * @brief Runs pareto_greedy for the weighting of a worker (pthread entry point)
+ *
+ * Only the state of the worker is written, nothing is allocated.
+ *
+ * @param arg ParetoWorker to evaluate
+ * @return NULL
+ */
+void* pareto_worker(void* arg);
+
+/**
+ * @brief Keeps a solution if no solution found so far dominates it
+ *
+ * Solutions it dominates (as many or more antennas, as large or larger sum
+ * of radii) are dropped.
+ *
+ * @param scene Current scene
+ * @param search Candidate sets
+ * @param pareto Exploration state, holding the solutions found so far
+ * @param selected Whether each candidate is in the solution
+ * @return true on success, false if memory is exhausted
+ */
+bool pareto_archive(const Scene* scene, const CoverSearch* search, ParetoSearch* pareto,
+                    const bool* selected);
+
+/**
+ * @brief Prints scene bounding box
+ * @param scene Scene to analyze
+ * @param output Stream to print to
+ */
+void print_bounding_box(const Scene* scene, FILE* output);
+
+/**
+ * @brief Prints scene summary
+ * @param scene Scene to summarize
+ * @param output Stream to print to
+ */
+void print_summary(const Scene* scene, FILE* output);
+
+/**
+ * @brief Prints building details
+ * @param b Building to print
+ * @param output Stream to print to
+ */
+void print_building(const Building* b, FILE* output);
+
+/**
+ * @brief Prints antenna details
+ * @param a Antenna to print
+ * @param output Stream to print to
+ */
+void print_antenna(const Antenna* a, FILE* output);
+
+/**
+ * @brief Comparison function for sorting IDs
+ * @param a First ID to compare
+ * @param b Second ID to compare
+ * @return Negative if a<b, 0 if equal, positive if a>b
+ */
+int compare_ids(const void* a, const void* b);
+
+/**
+ * @brief Comparison function for sorting buildings by ID
+ * @param a Pointer to the first building pointer
+ * @param b Pointer to the second building pointer
+ * @return Negative if a<b, 0 if equal, positive if a>b
+ */
+int compare_buildings(const void* a, const void* b);
+
+/**
+ * @brief Comparison function for sorting antennas by ID
+ * @param a Pointer to the first antenna pointer
+ * @param b Pointer to the second antenna pointer
+ * @return Negative if a<b, 0 if equal, positive if a>b
+ */
+int compare_antennas(const void* a, const void* b);
+
+/**
+ * @brief Comparison function for sorting trade-off solutions by number of antennas
+ * @param a Pointer to the first solution
+ * @param b Pointer to the second solution
+ * @return Negative if a has fewer antennas, 0 if as many, positive otherwise
+ */
+int compare_solutions(const void* a, const void* b);
+
+/**
+ * @brief Prints detailed scene description
+ * @param scene Scene to describe
+ * @param output Stream to print to
+ * @return false if memory is exhausted, true otherwise
+ */
+bool print_description(const Scene* scene, FILE* output);
+
+/**
+ * @brief Prints a minimum set of antennas fully covering every building
+ *
+ * When the exact search runs out of nodes (cover --max-nodes) or the scene
+ * is too large for its bitsets, the best cover found is printed as not
+ * proven minimum.
+ *
+ * @param scene Scene to analyze
+ * @param output Stream to print to
+ * @return false if memory is exhausted, true otherwise
+ */
+bool print_minimum_cover(const Scene* scene, FILE* output);
+
+/**
+ * @brief Prints a scene holding the buildings and the antennas of a solution
+ * @param scene Current scene
+ * @param search Candidate sets
+ * @param solution Solution to print
+ * @param output Stream to print to
+ */
+void print_solution_scene(const Scene* scene, const CoverSearch* search,
+                          const ParetoSolution* solution, FILE* output);
+
+/**
+ * @brief Prints the non-dominated trade-offs between antennas and radii
+ *
+ * Each solution is printed as a scene, by increasing number of antennas
+ * (and so decreasing sum of radii).
+ *
+ * @param scene Scene to analyze
+ * @param output Stream to print to
+ * @return false if memory is exhausted, true otherwise
+ */
+bool print_pareto_frontier(const Scene* scene, FILE* output);
+
+/**
+ * @brief Counts the antennas fully covering each building
+ *
+ * Each antenna only tests the buildings the grid finds within its box.
+ *
+ * @param scene Current scene
+ * @param counts Output number of covering antennas of each building
+ * @param found Work array, large enough for all the buildings
+ */
+void count_building_coverage(const Scene* scene, int* counts, int* found);
+
+/**
+ * @brief Prints the buildings covered by fewer antennas than required
+ *        (subcommand_args.min_coverage), by identifier, and the histogram
+ *        of the number of antennas covering each building
+ * @param scene Scene to analyze
+ * @param output Stream to print to
+ * @return false if memory is exhausted, true otherwise
+ */
+bool print_coverage_report(const Scene* scene, FILE* output);
+
+/**
+ * @brief Comparison function for sorting neighbour points by identifier
+ * @param a Pointer to the first point
+ * @param b Pointer to the second point
+ * @return Negative if a<b, 0 if equal, positive if a>b
+ */
+int compare_points(const void* a, const void* b);
+
+/**
+ * @brief Prints the nearest neighbour of each point, by identifier, and the
+ *        histogram of the distances (power of two buckets)
+ * @param points Points with their nearest neighbours, sorted by identifier
+ * @param n Number of points
+ * @param kind Kind of the entities ("building" or "antenna")
+ * @param output Stream to print to
+ */
+void print_neighbours(const NeighbourPoint* points, int n, const char* kind, FILE* output);
+
+/**
+ * @brief Prints the nearest building of each building (between centers) and
+ *        the nearest antenna of each antenna, with the distance histograms
+ * @param scene Scene to analyze
+ * @param output Stream to print to
+ * @return false if memory is exhausted, true otherwise
+ */
+bool print_nearest_neighbours(const Scene* scene, FILE* output);
+
+/**
+ * @brief Prints, for each antenna by identifier, the building it stands on
+ *        or that it is ground-mounted
+ * @param scene Scene to analyze
+ * @param output Stream to print to
+ * @return false if memory is exhausted, true otherwise
+ */
+bool print_rooftops(const Scene* scene, FILE* output);
+
+/**
+ * @brief Prints a point with two decimals (without negative zeros)
+ * @param p Point to print
+ * @param output Stream to print to
+ */
+void print_hull_point(const HullPoint* p, FILE* output);
+
+/**
+ * @brief Prints the convex hull of the scene, its minimum area oriented
+ *        bounding box and its minimum enclosing circle
+ * @param scene Scene to analyze
+ * @param output Stream to print to
+ * @return false if memory is exhausted, true otherwise
+ */
+bool print_hull(const Scene* scene, FILE* output);
+
+// --------------------------------------------------------
+// SECTION: UTILITY AND VALIDATION FUNCTIONS
+// --------------------------------------------------------
+
+bool is_blank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+bool is_valid_id_char(char c, bool first) {
+    if (first) 
+        return isalpha(c) || c == '_';
+    return isalnum(c) || c == '_';
+}
+
+bool is_valid_id(const char* id) {
+    if (!id[0]) return false;
+    if (!is_valid_id_char(id[0], true)) return false;
+    
+    for (int i = 1; id[i]; i++) {
+        if (!is_valid_id_char(id[i], false)) return false;
+    }
+    return true;
+}
+
+bool is_valid_integer(const char* str) {
+    if (!str[0]) return false;
+    if (str[0] == '0' && str[1]) return false;
+    
+    int start = (str[0] == '-') ? 1 : 0;
+    if (start == 1 && !str[1]) return false;
+    
+    for (int i = start; str[i]; i++) {
+        if (!isdigit(str[i])) return false;
+    }
+    return true;
+}
+
+bool is_valid_positive_integer(const char* str) {
+    if (!str[0] || str[0] == '-' || str[0] == '0') return false;
+    
+    for (int i = 0; str[i]; i++) {
+        if (!isdigit(str[i])) return false;
+    }
+    return true;
+}
+
+bool is_valid_azimuth(const char* str) {
+    if (strcmp(str, "0") == 0) return true;
+    return is_valid_positive_integer(str) && strlen(str) <= 3 && atoi(str) < FULL_CIRCLE;
+}
+
+bool is_valid_beamwidth(const char* str) {
+    return is_valid_positive_integer(str) && strlen(str) <= 3 && atoi(str) <= FULL_CIRCLE;
+}
+
+bool is_valid_subcommand(const char* subcommand) {
+    for (int i = 0; i < NUM_SUBCOMMANDS; i++) {
+        if (strcmp(subcommand, VALID_SUBCOMMANDS[i]) == 0) return true;
+    }
+    return false;
+}
+
+bool is_scene_subcommand(const char* subcommand) {
+    return strcmp(subcommand, "bounding-box") == 0 ||
+           strcmp(subcommand, "cover") == 0 ||
+           strcmp(subcommand, "coverage") == 0 ||
+           strcmp(subcommand, "describe") == 0 ||
+           strcmp(subcommand, "hull") == 0 ||
+           strcmp(subcommand, "nearest") == 0 ||
+           strcmp(subcommand, "optimize") == 0 ||
+           strcmp(subcommand, "rooftops") == 0 ||
+           strcmp(subcommand, "summarize") == 0;
+}
+
+bool is_begin_scene(const char* line) {
+    return strcmp(line, "begin scene") == 0;
+}
+
+bool is_end_scene(const char* line) {
+    return strcmp(line, "end scene") == 0;
+}
+
+void trim_line(char* line) {
+    char* end = line + strlen(line) - 1;
+    while (end > line && is_blank(*end)) end--;
+    *(end + 1) = '\0';
+    
+    while (*line && is_blank(*line)) line++;
+}
+
+// --------------------------------------------------------
+// SECTION: ERROR HANDLING FUNCTIONS
+// --------------------------------------------------------
+
+void print_error_line(int line_num) {
+    fprintf(stderr, "error: unrecognized line (line #%d)\n", line_num);
+}
+
+void print_error_mandatory() {
+    fprintf(stderr, "error: subcommand is mandatory\n");
+}
+
+void print_error_unrecognized(const char* subcommand) {
+    fprintf(stderr, "error: subcommand '%s' is not recognized\n", subcommand);
+}
+
+void print_error_memory() {
+    pthread_mutex_lock(&memory_lock);
+    bool budget_exceeded = memory.budget_exceeded;
+    pthread_mutex_unlock(&memory_lock);
+    if (budget_exceeded) {
+        fprintf(stderr, "error: memory budget of %zu bytes exceeded\n", memory.budget);
+        return;
+    }
+    fprintf(stderr, "error: out of memory\n");
+}
+
+void print_error_watch_usage() {
+    fprintf(stderr, "error: watch expects a subcommand and a file\n");
+}
+
+void print_error_file(const char* path) {
+    fprintf(stderr, "error: cannot open file '%s'\n", path);
+}
+
+void print_error_option(const char* option) {
+    fprintf(stderr, "error: option '%s' is not recognized\n", option);
+}
+
+void print_error_option_argument(const char* option) {
+    fprintf(stderr, "error: option '%s' requires an argument\n", option);
+}
+
+void print_error_memory_size(const char* size) {
+    fprintf(stderr, "error: invalid memory size \"%s\"\n", size);
+}
+
+void print_error_spacing(const char* spacing) {
+    fprintf(stderr, "error: invalid antenna spacing \"%s\"\n", spacing);
+}
+
+void print_error_jobs(const char* jobs) {
+    fprintf(stderr, "error: invalid number of jobs \"%s\"\n", jobs);
+}
+
+void print_error_subcommand_argument(const char* subcommand, const char* argument) {
+    fprintf(stderr, "error: argument '%s' is not accepted by subcommand '%s'\n",
+            argument, subcommand);
+}
+
+void print_error_optimize_mode() {
+    fprintf(stderr, "error: optimize expects a mode (--pareto)\n");
+}
+
+void print_error_argument_value(const char* argument, const char* value) {
+    fprintf(stderr, "error: invalid value \"%s\" for argument '%s'\n", value, argument);
+}
+
+void print_help() {
+    printf("Usage: kover SUBCOMMAND\n");
+    printf("Handles positioning of communication antennas by reading a scene on stdin.\n");
+    printf("Several scenes may follow each other on stdin, each one being processed\n");
+    printf("as soon as it is complete.\n\n");
+    printf("SUBCOMMAND is mandatory and must take one of the following values:\n");
+    printf("  bounding-box: returns a bounding box of the loaded scene\n");
+    printf("  cover [--max-nodes N]: finds a minimum set of antennas of the scene\n");
+    printf("    fully covering every building, or the best set found within N nodes\n");
+    printf("    of the search (by default, fewer nodes on larger scenes)\n");
+    printf("  coverage [--min K]: lists the buildings fully covered by fewer than K\n");
+    printf("    antennas (default 1) and the histogram of the number of antennas\n");
+    printf("    covering each building\n");
+    printf("  describe: describes the loaded scene in details\n");
+    printf("  help: shows this message\n");
+    printf("  hull [--sides N]: prints the convex hull of the buildings and of the\n");
+    printf("    antenna disks (circumscribed polygons of N sides, default 32), its\n");
+    printf("    minimum area oriented bounding box and minimum enclosing circle\n");
+    printf("  nearest: prints the nearest building of each building (between centers)\n");
+    printf("    and the nearest antenna of each antenna, with distance histograms\n");
+    printf("  optimize --pareto [--threads N]: prints, as scenes, the covers of the\n");
+    printf("    buildings found that no other cover beats on both the number of\n");
+    printf("    antennas and the sum of their radii, explored by N threads (default\n");
+    printf("    one per processor, at most 64)\n");
+    printf("  rooftops: prints the building each antenna stands on, if any\n");
+    printf("  summarize: summarizes the loaded scene\n");
+    printf("  watch SUBCOMMAND [ARGUMENTS] FILE: runs SUBCOMMAND on FILE instead of\n");
+    printf("    stdin, and again each time FILE is modified\n\n");
+    printf("Options may precede SUBCOMMAND:\n");
+    printf("  --stats: prints statistics of the run on stderr (Prometheus text format)\n");
+    printf("  --trace FILE: writes the timeline of internal phases to FILE (Chrome\n");
+    printf("    trace JSON format)\n");
+    printf("  --max-memory SIZE: fails as soon as kover needs more than SIZE bytes\n");
+    printf("    (K, M and G suffixes are accepted)\n");
+    printf("  --cache-size SIZE: keeps up to SIZE bytes of results of the versions of\n");
+    printf("    a watched file, republished if the file returns to one of them\n");
+    printf("    (default 16M, 0 disables the cache)\n");
+    printf("  --min-antenna-spacing D: rejects scenes with two antennas closer than D\n");
+    printf("  --jobs N: runs SUBCOMMAND on up to N scenes of a stream at once, in\n");
+    printf("    worker threads, the results keeping the order of the scenes (1 to 64,\n");
+    printf("    default 1)\n\n");
+    printf("A scene is a text stream that must satisfy the following syntax:\n\n");
+    printf("  1. The first line must be exactly 'begin scene'\n");
+    printf("  2. The last line must be exactly 'end scene'\n");
+    printf("  3. Any line between the first and last line must either be a building line\n");
+    printf("     or an antenna line\n");
+    printf("  4. A building line has the form 'building ID X Y W H' (with any number of\n");
+    printf("     blank characters before or after), where\n");
+    printf("       ID is the building identifier\n");
+    printf("       X is the x-coordinate of the building\n");
+    printf("       Y is the y-coordinate of the building\n");
+    printf("       W is the half-width of the building\n");
+    printf("       H is the half-height of the building\n");
+    printf("  5. An antenna line has the form 'antenna ID X Y R' (with any number of\n");
+    printf("     blank characters before or after), where\n");
+    printf("       ID is the building identifier\n");
+    printf("       X is the x-coordinate of the antenna\n");
+    printf("       Y is the y-coordinate of the antenna\n");
+    printf("       R is the radius scope of the antenna\n");
+    printf("  6. A sector antenna line has the form 'antenna ID X Y R AZ BW', where\n");
+    printf("       AZ is the azimuth of the sector in degrees (0 to 359, clockwise\n");
+    printf("          from north)\n");
+    printf("       BW is the beamwidth of the sector in degrees (1 to 360)\n");
+}
+
+// --------------------------------------------------------
+// SECTION: MEMORY ACCOUNTING FUNCTIONS
+// --------------------------------------------------------
+
+void* kover_malloc(size_t size, MemSubsystem subsystem) {
+    return kover_realloc(NULL, 0, size, subsystem);
+}
+
+void* kover_realloc(void* ptr, size_t old_size, size_t new_size, MemSubsystem subsystem) {
+    pthread_mutex_lock(&memory_lock);
+    if (new_size > old_size && memory.budget &&
+        memory.total + (new_size - old_size) > memory.budget) {
+        memory.budget_exceeded = true;
+        pthread_mutex_unlock(&memory_lock);
+        return NULL;
+    }
+
+    void* new_ptr = realloc(ptr, new_size);
+    if (!new_ptr) {
+        pthread_mutex_unlock(&memory_lock);
+        return NULL;
+    }
+
+    memory.current[subsystem] += new_size - old_size;
+    memory.total += new_size - old_size;
+    if (memory.current[subsystem] > memory.peak[subsystem]) {
+        memory.peak[subsystem] = memory.current[subsystem];
+    }
+    if (memory.total > memory.total_peak) memory.total_peak = memory.total;
+    pthread_mutex_unlock(&memory_lock);
+    return new_ptr;
+}
+
+void kover_free(void* ptr, size_t size, MemSubsystem subsystem) {
+    if (!ptr) return;
+    free(ptr);
+    pthread_mutex_lock(&memory_lock);
+    memory.current[subsystem] -= size;
+    memory.total -= size;
+    pthread_mutex_unlock(&memory_lock);
+}
+
+bool parse_memory_size(const char* str, size_t* size) {
+    char* end;
+    if (!isdigit((unsigned char)str[0])) return false;
+    unsigned long long value = strtoull(str, &end, 10);
+
+    unsigned long long unit = 1;
+    if (*end == 'K') unit = 1ULL << 10;
+    else if (*end == 'M') unit = 1ULL << 20;
+    else if (*end == 'G') unit = 1ULL << 30;
+    if (unit > 1) end++;
+
+    if (*end || value == 0 || value > SIZE_MAX / unit) return false;
+    *size = value * unit;
+    return true;
+}
+
+// --------------------------------------------------------
+// SECTION: MEMORY ARENA FUNCTIONS
+// --------------------------------------------------------
+
+void* arena_alloc(Arena* arena, size_t size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+    while (arena->current && arena->current->used + size > arena->current->size
+           && arena->current->next) {
+        arena->current = arena->current->next;
+        arena->current->used = 0;
+    }
+
+    if (!arena->current || arena->current->used + size > arena->current->size) {
+        size_t chunk_size = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+        ArenaChunk* chunk = kover_malloc(sizeof(ArenaChunk) + chunk_size, arena->subsystem);
+        if (!chunk) return NULL;
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        if (arena->current) {
+            chunk->next = arena->current->next;
+            arena->current->next = chunk;
+        } else {
+            chunk->next = NULL;
+            arena->head = chunk;
+        }
+        arena->current = chunk;
+    }
+
+    void* ptr = arena->current->data + arena->current->used;
+    arena->current->used += size;
+    return ptr;
+}
+
+void arena_rewind(Arena* arena) {
+    arena->current = arena->head;
+    if (arena->current) arena->current->used = 0;
+}
+
+void arena_free(Arena* arena) {
+    ArenaChunk* chunk = arena->head;
+    while (chunk) {
+        ArenaChunk* next = chunk->next;
+        kover_free(chunk, sizeof(ArenaChunk) + chunk->size, arena->subsystem);
+        chunk = next;
+    }
+    arena->head = NULL;
+    arena->current = NULL;
+}
+
+bool arena_grow_array(Arena* arena, void** items, unsigned int* capacity, size_t item_size) {
+    unsigned int new_capacity = *capacity ? *capacity * 2 : INITIAL_CAPACITY;
+    void* new_items = arena_alloc(arena, new_capacity * item_size);
+    if (!new_items) return false;
+    if (*items) memcpy(new_items, *items, *capacity * item_size);
+    *items = new_items;
+    *capacity = new_capacity;
+    return true;
+}
+
+// --------------------------------------------------------
+// SECTION: INDEX FUNCTIONS
+// --------------------------------------------------------
+
+unsigned int hash_id(const char* id) {
+    unsigned int hash = 2166136261u;
+    for (int i = 0; id[i]; i++) {
+        hash ^= (unsigned char)id[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+int id_index_find(const IdIndex* index, const void* items, size_t stride, const char* id) {
+    if (index->capacity == 0) return -1;
+
+    stats.id_lookups++;
+    unsigned int mask = index->capacity - 1;
+    for (unsigned int i = hash_id(id) & mask; index->slots[i]; i = (i + 1) & mask) {
+        stats.id_probes++;
+        unsigned int item = index->slots[i] - 1;
+        if (strcmp((const char*)items + item * stride, id) == 0) return item;
+    }
+    return -1;
+}
+
+bool id_index_insert(IdIndex* index, Arena* arena, const void* items, size_t stride,
+                     unsigned int item) {
+    if (2 * (index->count + 1) > index->capacity) {
+        trace_event("id_index_rehash", 'B');
+        unsigned int new_capacity = index->capacity ? index->capacity * 2 : INITIAL_CAPACITY;
+        unsigned int* new_slots = arena_alloc(arena, new_capacity * sizeof(unsigned int));
+        if (!new_slots) {
+            trace_event("id_index_rehash", 'E');
+            return false;
+        }
+        memset(new_slots, 0, new_capacity * sizeof(unsigned int));
+
+        for (unsigned int i = 0; i < index->capacity; i++) {
+            if (!index->slots[i]) continue;
+            const char* id = (const char*)items + (index->slots[i] - 1) * stride;
+            unsigned int j = hash_id(id) & (new_capacity - 1);
+            while (new_slots[j]) j = (j + 1) & (new_capacity - 1);
+            new_slots[j] = index->slots[i];
+        }
+        index->slots = new_slots;
+        index->capacity = new_capacity;
+        trace_event("id_index_rehash", 'E');
+        KOVER_PROBE2(index__rebuild, "id", new_capacity);
+    }
+
+    unsigned int mask = index->capacity - 1;
+    unsigned int i = hash_id((const char*)items + item * stride) & mask;
+    while (index->slots[i]) i = (i + 1) & mask;
+    index->slots[i] = item + 1;
+    index->count++;
+    return true;
+}
+
+unsigned int hash_cell(int level, long long cx, long long cy) {
+    unsigned long long hash = (unsigned long long)cx * 0x9E3779B97F4A7C15ull;
+    hash ^= (unsigned long long)cy * 0xC2B2AE3D27D4EB4Full;
+    hash ^= (unsigned long long)level * 0x165667B19E3779F9ull;
+    hash ^= hash >> 29;
+    return (unsigned int)hash;
+}
+
+void grid_index_init(GridIndex* grid) {
+    grid->buckets = NULL;
+    grid->num_buckets = 0;
+    grid->entries = NULL;
+    grid->num_entries = 0;
+    grid->entries_capacity = 0;
+    for (int level = 0; level < GRID_LEVELS; level++) grid->level_counts[level] = 0;
+}
+
+bool grid_index_insert(GridIndex* grid, Arena* arena, int level, long long cx,
+                       long long cy, int item) {
+    if (grid->num_entries == grid->entries_capacity &&
+        !arena_grow_array(arena, (void**)&grid->entries, &grid->entries_capacity,
+                          sizeof(GridEntry))) {
+        return false;
+    }
+
+    if (grid->num_entries + 1 > grid->num_buckets) {
+        trace_event("grid_index_rehash", 'B');
+        unsigned int new_size = grid->num_buckets ? grid->num_buckets * 2 : INITIAL_CAPACITY;
+        int* new_buckets = arena_alloc(arena, new_size * sizeof(int));
+        if (!new_buckets) {
+            trace_event("grid_index_rehash", 'E');
+            return false;
+        }
+        for (unsigned int i = 0; i < new_size; i++) new_buckets[i] = NO_ENTRY;
+        for (unsigned int e = 0; e < grid->num_entries; e++) {
+            GridEntry* entry = &grid->entries[e];
+            unsigned int b = hash_cell(entry->level, entry->cx, entry->cy) & (new_size - 1);
+            entry->next = new_buckets[b];
+            new_buckets[b] = e;
+        }
+        grid->buckets = new_buckets;
+        grid->num_buckets = new_size;
+        trace_event("grid_index_rehash", 'E');
+        KOVER_PROBE2(index__rebuild, "grid", new_size);
+    }
+
+    int e = grid->num_entries++;
+    GridEntry* entry = &grid->entries[e];
+    unsigned int b = hash_cell(level, cx, cy) & (grid->num_buckets - 1);
+    entry->cx = cx;
+    entry->cy = cy;
+    entry->level = level;
+    entry->item = item;
+    entry->next = grid->buckets[b];
+    grid->buckets[b] = e;
+    return true;
+}
+
+int grid_cell_skip(const GridIndex* grid, int entry, int level, long long cx,
+                   long long cy) {
+    while (entry != NO_ENTRY) {
+        stats.grid_visits++;
+        const GridEntry* e = &grid->entries[entry];
+        if (e->level == level && e->cx == cx && e->cy == cy) return entry;
+        entry = e->next;
+    }
+    return NO_ENTRY;
+}
+
+int grid_cell_first(const GridIndex* grid, int level, long long cx, long long cy) {
+    if (grid->num_buckets == 0) return NO_ENTRY;
+    int entry = grid->buckets[hash_cell(level, cx, cy) & (grid->num_buckets - 1)];
+    return grid_cell_skip(grid, entry, level, cx, cy);
+}
+
+int grid_cell_next(const GridIndex* grid, int entry) {
+    const GridEntry* e = &grid->entries[entry];
+    return grid_cell_skip(grid, e->next, e->level, e->cx, e->cy);
+}
+
+int grid_summary_level(int level, int depth) {
+    return level + depth * GRID_LEVELS;
+}
+
+bool grid_summary_insert(GridIndex* grid, Arena* arena, int level, long long cx,
+                         long long cy) {
+    for (int depth = 1; depth <= GRID_SUMMARY_DEPTHS; depth++) {
+        int shift = depth * GRID_SUMMARY_SHIFT;
+        int summary = grid_summary_level(level, depth);
+        if (grid_cell_first(grid, summary, cx >> shift, cy >> shift) != NO_ENTRY) break;
+        if (!grid_index_insert(grid, arena, summary, cx >> shift, cy >> shift, NO_ENTRY)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void grid_walk_start(GridWalk* walk, int level, long long cx0, long long cx1,
+                     long long cy0, long long cy1) {
+    int top = 0;
+    while (top < GRID_SUMMARY_DEPTHS) {
+        int shift = top * GRID_SUMMARY_SHIFT;
+        unsigned long long columns = (cx1 >> shift) - (cx0 >> shift) + 1;
+        unsigned long long rows = (cy1 >> shift) - (cy0 >> shift) + 1;
+        if (columns <= GRID_WALK_CELLS && rows <= GRID_WALK_CELLS / columns) break;
+        top++;
+    }
+    int shift = top * GRID_SUMMARY_SHIFT;
+    walk->level = level;
+    walk->depth = top;
+    walk->top = top;
+    walk->entry = NO_ENTRY;
+    walk->cx0 = cx0;
+    walk->cx1 = cx1;
+    walk->cy0 = cy0;
+    walk->cy1 = cy1;
+    walk->frames[top] = (GridWalkFrame){cx0 >> shift, cx1 >> shift, cy0 >> shift,
+                                        cy1 >> shift, cx0 >> shift, cy0 >> shift};
+}
+
+int grid_walk_next(const GridIndex* grid, GridWalk* walk) {
+    if (walk->entry != NO_ENTRY) {
+        walk->entry = grid_cell_next(grid, walk->entry);
+        if (walk->entry != NO_ENTRY) return walk->entry;
+    }
+
+    while (true) {
+        GridWalkFrame* frame = &walk->frames[walk->depth];
+        if (frame->cx > frame->cx1) {
+            // Box of this depth exhausted: resume the summary cell above
+            if (walk->depth == walk->top) return NO_ENTRY;
+            walk->depth++;
+            continue;
+        }
+        long long cx = frame->cx, cy = frame->cy;
+        if (++frame->cy > frame->cy1) {
+            frame->cy = frame->cy0;
+            frame->cx++;
+        }
+
+        if (walk->depth == 0) {
+            walk->entry = grid_cell_first(grid, walk->level, cx, cy);
+            if (walk->entry != NO_ENTRY) return walk->entry;
+            continue;
+        }
+        if (grid_cell_first(grid, grid_summary_level(walk->level, walk->depth), cx, cy) ==
+            NO_ENTRY) {
+            continue;
+        }
+
+        // Descend into the cells of the summary cell that are in the box
+        int shift = (walk->depth - 1) * GRID_SUMMARY_SHIFT;
+        long long cx0 = walk->cx0 >> shift, cx1 = walk->cx1 >> shift;
+        long long cy0 = walk->cy0 >> shift, cy1 = walk->cy1 >> shift;
+        long long first_cx = cx * (1LL << GRID_SUMMARY_SHIFT);
+        long long first_cy = cy * (1LL << GRID_SUMMARY_SHIFT);
+        long long last_cx = first_cx + (1 << GRID_SUMMARY_SHIFT) - 1;
+        long long last_cy = first_cy + (1 << GRID_SUMMARY_SHIFT) - 1;
+        GridWalkFrame* child = &walk->frames[--walk->depth];
+        child->cx0 = first_cx > cx0 ? first_cx : cx0;
+        child->cx1 = last_cx < cx1 ? last_cx : cx1;
+        child->cy0 = first_cy > cy0 ? first_cy : cy0;
+        child->cy1 = last_cy < cy1 ? last_cy : cy1;
+        child->cx = child->cx0;
+        child->cy = child->cy0;
+    }
+}
+
+int building_level(const Building* b) {
+    long long extent = 2LL * (b->w > b->h ? b->w : b->h);
+    int level = 0;
+    while (level < GRID_LEVELS - 1 && (1LL << level) < extent) level++;
+    return level;
+}
+
+// --------------------------------------------------------
+// SECTION: SCENE AND BUILDING VALIDATION FUNCTIONS
+// --------------------------------------------------------
+
+bool buildings_overlap(const Building* b1, const Building* b2) {
+    return !(b1->x + b1->w <= b2->x - b2->w || 
+             b1->x - b1->w >= b2->x + b2->w ||
+             b1->y + b1->h <= b2->y - b2->h || 
+             b1->y - b1->h >= b2->y + b2->h);
+}
+
+bool is_duplicate_building_id(const Scene* scene, const char* id) {
+    return id_index_find(&scene->building_ids, scene->buildings, sizeof(Building), id) >= 0;
+}
+
+bool is_duplicate_antenna_id(const Scene* scene, const char* id) {
+    return id_index_find(&scene->antenna_ids, scene->antennas, sizeof(Antenna), id) >= 0;
+}
+
+int find_overlapping_building(const Scene* scene, const Building* b) {
+    const GridIndex* grid = &scene->building_grid;
+    long long min_x = (long long)b->x - b->w, max_x = (long long)b->x + b->w;
+    long long min_y = (long long)b->y - b->h, max_y = (long long)b->y + b->h;
+    int first = -1;
+
+    stats.grid_lookups++;
+    for (int level = 0; level < GRID_LEVELS; level++) {
+        if (grid->level_counts[level] == 0) continue;
+
+        GridWalk walk;
+        grid_walk_start(&walk, level, min_x >> level, max_x >> level, min_y >> level,
+                        max_y >> level);
+        for (int e = grid_walk_next(grid, &walk); e != NO_ENTRY; e = grid_walk_next(grid, &walk)) {
+            int item = grid->entries[e].item;
+            if ((first < 0 || item < first) && buildings_overlap(&scene->buildings[item], b)) {
+                first = item;
+            }
+        }
+    }
+    return first;
+}
+
+int find_antenna_at(const Scene* scene, int x, int y) {
+    stats.grid_lookups++;
+    int e = grid_cell_first(&scene->antenna_positions, 0, x, y);
+    return e == NO_ENTRY ? -1 : scene->antenna_positions.entries[e].item;
+}
+
+int find_building_at(const Scene* scene, int x, int y) {
+    // A point touches at most 4 buildings, which cannot overlap
+    int found[4];
+    int count = find_buildings_in_box(scene, x, x, y, y, found);
+    int first = -1;
+    for (int k = 0; k < count; k++) {
+        if (first < 0 || found[k] < first) first = found[k];
+    }
+    return first;
+}
+
+bool antennas_too_close(const Antenna* a1, const Antenna* a2) {
+    long long dx = llabs((long long)a1->x - a2->x), dy = llabs((long long)a1->y - a2->y);
+    long long spacing = rules.min_antenna_spacing;
+    return dx < spacing && dy < spacing && dx * dx + dy * dy < spacing * spacing;
+}
+
+int find_close_antenna(const Scene* scene, const Antenna* a) {
+    int level = rules.spacing_level;
+    long long cx = (long long)a->x >> level, cy = (long long)a->y >> level;
+    int first = -1;
+
+    stats.grid_lookups++;
+    for (long long gx = cx - 1; gx <= cx + 1; gx++) {
+        for (long long gy = cy - 1; gy <= cy + 1; gy++) {
+            for (int e = grid_cell_first(&scene->antenna_spacing, level, gx, gy); e != NO_ENTRY;
+                 e = grid_cell_next(&scene->antenna_spacing, e)) {
+                int item = scene->antenna_spacing.entries[e].item;
+                if ((first < 0 || item < first) &&
+                    antennas_too_close(&scene->antennas[item], a)) {
+                    first = item;
+                }
+            }
+        }
+    }
+    return first;
+}
+
+int find_buildings_in_box(const Scene* scene, long long min_x, long long max_x,
+                          long long min_y, long long max_y, int* found) {
+    const GridIndex* grid = &scene->building_grid;
+    int count = 0;
+
+    stats.grid_lookups++;
+    for (int level = 0; level < GRID_LEVELS; level++) {
+        if (grid->level_counts[level] == 0) continue;
+
+        GridWalk walk;
+        grid_walk_start(&walk, level, min_x >> level, max_x >> level, min_y >> level,
+                        max_y >> level);
+        for (int e = grid_walk_next(grid, &walk); e != NO_ENTRY; e = grid_walk_next(grid, &walk)) {
+            const GridEntry* entry = &grid->entries[e];
+            const Building* b = &scene->buildings[entry->item];
+            long long bx0 = (long long)b->x - b->w, bx1 = (long long)b->x + b->w;
+            long long by0 = (long long)b->y - b->h, by1 = (long long)b->y + b->h;
+            // A building spans several cells: only its first cell in the box reports it
+            long long first_cx = (bx0 > min_x ? bx0 : min_x) >> level;
+            long long first_cy = (by0 > min_y ? by0 : min_y) >> level;
+            if (entry->cx == first_cx && entry->cy == first_cy &&
+                bx0 <= max_x && bx1 >= min_x && by0 <= max_y && by1 >= min_y) {
+                found[count++] = entry->item;
+            }
+        }
+    }
+    return count;
+}
+
+bool check_building_overlaps(const Scene* scene, char* id1, char* id2) {
+    for (int i = 0; i < scene->num_buildings; i++) {
+        for (int j = i + 1; j < scene->num_buildings; j++) {
+            if (buildings_overlap(&scene->buildings[i], &scene->buildings[j])) {
+                strcpy(id1, scene->buildings[i].id);
+                strcpy(id2, scene->buildings[j].id);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool has_same_position(const Antenna* a1, const Antenna* a2) {
+    return (a1->x == a2->x && a1->y == a2->y);
+}
+
+bool check_antenna_positions(const Scene* scene, char* id1, char* id2) {
+    for (int i = 0; i < scene->num_antennas; i++) {
+        for (int j = i + 1; j < scene->num_antennas; j++) {
+            if (has_same_position(&scene->antennas[i], &scene->antennas[j])) {
+                strcpy(id1, scene->antennas[i].id);
+                strcpy(id2, scene->antennas[j].id);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int reference_find_overlapping_building(const Scene* scene, const Building* b) {
+    for (int i = 0; i < scene->num_buildings; i++) {
+        if (buildings_overlap(&scene->buildings[i], b)) return i;
+    }
+    return -1;
+}
+
+int reference_find_antenna_at(const Scene* scene, int x, int y) {
+    for (int i = 0; i < scene->num_antennas; i++) {
+        if (scene->antennas[i].x == x && scene->antennas[i].y == y) return i;
+    }
+    return -1;
+}
+
+int reference_find_close_antenna(const Scene* scene, const Antenna* a) {
+    for (int i = 0; i < scene->num_antennas; i++) {
+        if (antennas_too_close(&scene->antennas[i], a)) return i;
+    }
+    return -1;
+}
+
+bool reference_is_duplicate_building_id(const Scene* scene, const char* id) {
+    for (int i = 0; i < scene->num_buildings; i++) {
+        if (strcmp(scene->buildings[i].id, id) == 0) return true;
+    }
+    return false;
+}
+
+bool reference_is_duplicate_antenna_id(const Scene* scene, const char* id) {
+    for (int i = 0; i < scene->num_antennas; i++) {
+        if (strcmp(scene->antennas[i].id, id) == 0) return true;
+    }
+    return false;
+}
+
+// --------------------------------------------------------
+// SECTION: PARSING FUNCTIONS
+// --------------------------------------------------------
+
+
+bool validate_building_args(const char* id, const char* x_str, const char* y_str,
+                          const char* w_str, const char* h_str, int line_num) {
+    if (!is_valid_id(id)) {
+        fprintf(stderr, "error: invalid identifier \"%s\" (line #%d)\n", id, line_num);
+        return false;
+    }
+    if (!is_valid_integer(x_str)) {
+        fprintf(stderr, "error: invalid integer \"%s\" (line #%d)\n", x_str, line_num);
+        return false;
+    }
+    if (!is_valid_integer(y_str)) {
+        fprintf(stderr, "error: invalid integer \"%s\" (line #%d)\n", y_str, line_num);
+        return false;
+    }
+    if (!is_valid_positive_integer(w_str)) {
+        fprintf(stderr, "error: invalid positive integer \"%s\" (line #%d)\n", w_str, line_num);
+        return false;
+    }
+    if (!is_valid_positive_integer(h_str)) {
+        fprintf(stderr, "error: invalid positive integer \"%s\" (line #%d)\n", h_str, line_num);
+        return false;
+    }
+    return true;
+}
+
+bool extract_building_args(const char* line, char* id, char* x_str, char* y_str,
+                         char* w_str, char* h_str, int line_num) {
+    if (sscanf(line, " building %10s %10s %10s %10s %10s ",
+               id, x_str, y_str, w_str, h_str) != 5) {
+        fprintf(stderr, "error: building line has wrong number of arguments (line #%d)\n", line_num);
+        return false;
+    }
+    return true;
+}
+
+void construct_building(Building* building, const char* id, const char* x_str,
+                      const char* y_str, const char* w_str, const char* h_str) {
+    strcpy(building->id, id);
+    building->x = atoi(x_str);
+    building->y = atoi(y_str);
+    building->w = atoi(w_str);
+    building->h = atoi(h_str);
+}
+
+bool parse_building_line(const char* line, Building* building, int line_num) {
+    char id[MAX_ID_LENGTH];
+    char x_str[MAX_ARG_LENGTH], y_str[MAX_ARG_LENGTH];
+    char w_str[MAX_ARG_LENGTH], h_str[MAX_ARG_LENGTH];
+    
+    if (!extract_building_args(line, id, x_str, y_str, w_str, h_str, line_num)) {
+        return false;
+    }
+    
+    if (!validate_building_args(id, x_str, y_str, w_str, h_str, line_num)) {
+        return false;
+    }
+    
+    construct_building(building, id, x_str, y_str, w_str, h_str);
+    return true;
+}
+
+bool validate_antenna_args(const char* id, const char* x_str, const char* y_str,
+                         const char* r_str, const char* az_str,
+                         const char* bw_str, int line_num) {
+    if (!is_valid_id(id)) {
+        fprintf(stderr, "error: invalid identifier \"%s\" (line #%d)\n", id, line_num);
+        return false;
+    }
+    if (!is_valid_integer(x_str)) {
+        fprintf(stderr, "error: invalid integer \"%s\" (line #%d)\n", x_str, line_num);
+        return false;
+    }
+    if (!is_valid_integer(y_str)) {
+        fprintf(stderr, "error: invalid integer \"%s\" (line #%d)\n", y_str, line_num);
+        return false;
+    }
+    if (!is_valid_positive_integer(r_str)) {
+        fprintf(stderr, "error: invalid positive integer \"%s\" (line #%d)\n", r_str, line_num);
+        return false;
+    }
+    if (az_str[0] && !is_valid_azimuth(az_str)) {
+        fprintf(stderr, "error: invalid azimuth \"%s\" (line #%d)\n", az_str, line_num);
+        return false;
+    }
+    if (bw_str[0] && !is_valid_beamwidth(bw_str)) {
+        fprintf(stderr, "error: invalid beamwidth \"%s\" (line #%d)\n", bw_str, line_num);
+        return false;
+    }
+    return true;
+}
+
+bool extract_antenna_args(const char* line, char* id, char* x_str, char* y_str,
+                        char* r_str, char* az_str, char* bw_str, int line_num) {
+    char extra[MAX_ARG_LENGTH];
+    az_str[0] = '\0';
+    bw_str[0] = '\0';
+    int count = sscanf(line, " antenna %10s %10s %10s %10s %10s %10s %10s ",
+                       id, x_str, y_str, r_str, az_str, bw_str, extra);
+    if (count != 4 && count != 6) {
+        fprintf(stderr, "error: antenna line has wrong number of arguments (line #%d)\n", line_num);
+        return false;
+    }
+    return true;
+}
+
+void construct_antenna(Antenna* antenna, const char* id, const char* x_str,
+                      const char* y_str, const char* r_str,
+                      const char* az_str, const char* bw_str) {
+    strcpy(antenna->id, id);
+    antenna->x = atoi(x_str);
+    antenna->y = atoi(y_str);
+    antenna->r = atoi(r_str);
+    antenna->azimuth = az_str[0] ? atoi(az_str) : DEFAULT_AZIMUTH;
+    antenna->beamwidth = bw_str[0] ? atoi(bw_str) : DEFAULT_BEAMWIDTH;
+    compute_antenna_bounds(antenna);
+}
+
+bool parse_antenna_line(const char* line, Antenna* antenna, int line_num) {
+    char id[MAX_ID_LENGTH];
+    char x_str[MAX_ARG_LENGTH], y_str[MAX_ARG_LENGTH], r_str[MAX_ARG_LENGTH];
+    char az_str[MAX_ARG_LENGTH], bw_str[MAX_ARG_LENGTH];
+    
+    if (!extract_antenna_args(line, id, x_str, y_str, r_str, az_str, bw_str, line_num)) {
+        return false;
+    }
+    
+    if (!validate_antenna_args(id, x_str, y_str, r_str, az_str, bw_str, line_num)) {
+        return false;
+    }
+    
+    construct_antenna(antenna, id, x_str, y_str, r_str, az_str, bw_str);
+    return true;
+}
+
+bool print_sorted_buildings(const Scene* scene, FILE* output) {
+    if (scene->num_buildings == 0) return true;
+    size_t size = scene->num_buildings * sizeof(Building*);
+    const Building** sorted = kover_malloc(size, MEM_OUTPUT);
+    if (!sorted) {
+        print_error_memory();
+        return false;
+    }
+    for (int i = 0; i < scene->num_buildings; i++) {
+        sorted[i] = &scene->buildings[i];
+    }
+    trace_event("sort_buildings", 'B');
+    qsort(sorted, scene->num_buildings, sizeof(Building*), compare_buildings);
+    trace_event("sort_buildings", 'E');
+    
+    for (int i = 0; i < scene->num_buildings; i++) {
+        print_building(sorted[i], output);
+    }
+    kover_free(sorted, size, MEM_OUTPUT);
+    return true;
+}
+
+bool print_sorted_antennas(const Scene* scene, FILE* output) {
+    if (scene->num_antennas == 0) return true;
+    size_t size = scene->num_antennas * sizeof(Antenna*);
+    const Antenna** sorted = kover_malloc(size, MEM_OUTPUT);
+    if (!sorted) {
+        print_error_memory();
+        return false;
+    }
+    for (int i = 0; i < scene->num_antennas; i++) {
+        sorted[i] = &scene->antennas[i];
+    }
+    trace_event("sort_antennas", 'B');
+    qsort(sorted, scene->num_antennas, sizeof(Antenna*), compare_antennas);
+    trace_event("sort_antennas", 'E');
+    
+    for (int i = 0; i < scene->num_antennas; i++) {
+        print_antenna(sorted[i], output);
+    }
+    kover_free(sorted, size, MEM_OUTPUT);
+    return true;
+}
+
+bool reference_print_sorted_buildings(const Scene* scene, FILE* output) {
+    if (scene->num_buildings == 0) return true;
+    size_t size = scene->num_buildings * sizeof(char*);
+    const char** building_ids = kover_malloc(size, MEM_OUTPUT);
+    if (!building_ids) {
+        print_error_memory();
+        return false;
+    }
+    for (int i = 0; i < scene->num_buildings; i++) {
+        building_ids[i] = scene->buildings[i].id;
+    }
+    qsort(building_ids, scene->num_buildings, sizeof(char*), compare_ids);
+    
+    for (int i = 0; i < scene->num_buildings; i++) {
+        for (int j = 0; j < scene->num_buildings; j++) {
+            if (strcmp(building_ids[i], scene->buildings[j].id) == 0) {
+                print_building(&scene->buildings[j], output);
+                break;
+            }
+        }
+    }
+    kover_free(building_ids, size, MEM_OUTPUT);
+    return true;
+}
+
+bool reference_print_sorted_antennas(const Scene* scene, FILE* output) {
+    if (scene->num_antennas == 0) return true;
+    size_t size = scene->num_antennas * sizeof(char*);
+    const char** antenna_ids = kover_malloc(size, MEM_OUTPUT);
+    if (!antenna_ids) {
+        print_error_memory();
+        return false;
+    }
+    for (int i = 0; i < scene->num_antennas; i++) {
+        antenna_ids[i] = scene->antennas[i].id;
+    }
+    qsort(antenna_ids, scene->num_antennas, sizeof(char*), compare_ids);
+    
+    for (int i = 0; i < scene->num_antennas; i++) {
+        for (int j = 0; j < scene->num_antennas; j++) {
+            if (strcmp(antenna_ids[i], scene->antennas[j].id) == 0) {
+                print_antenna(&scene->antennas[j], output);
+                break;
+            }
+        }
+    }
+    kover_free(antenna_ids, size, MEM_OUTPUT);
+    return true;
+}
+
+// --------------------------------------------------------
+// SECTION: SCENE PROCESSING FUNCTIONS
+// --------------------------------------------------------
+
+void init_scene(Scene* scene) {
+    scene->arena = (Arena){NULL, NULL, MEM_SCENE};
+    scene->id_arena = (Arena){NULL, NULL, MEM_ID_INDEX};
+    scene->grid_arena = (Arena){NULL, NULL, MEM_GRID_INDEX};
+    reset_scene(scene);
+}
+
+void reset_scene(Scene* scene) {
+    arena_rewind(&scene->arena);
+    arena_rewind(&scene->id_arena);
+    arena_rewind(&scene->grid_arena);
+    scene->buildings = NULL;
+    scene->num_buildings = 0;
+    scene->buildings_capacity = 0;
+    scene->antennas = NULL;
+    scene->num_antennas = 0;
+    scene->antennas_capacity = 0;
+    scene->building_ids = (IdIndex){NULL, 0, 0};
+    scene->antenna_ids = (IdIndex){NULL, 0, 0};
+    grid_index_init(&scene->building_grid);
+    grid_index_init(&scene->antenna_positions);
+    grid_index_init(&scene->antenna_spacing);
+}
+
+void free_scene(Scene* scene) {
+    arena_free(&scene->arena);
+    arena_free(&scene->id_arena);
+    arena_free(&scene->grid_arena);
+    reset_scene(scene);
+}
+
+bool add_building(Scene* scene, const Building* b) {
+    if (scene->num_buildings == scene->buildings_capacity &&
+        !arena_grow_array(&scene->arena, (void**)&scene->buildings,
+                          &scene->buildings_capacity, sizeof(Building))) {
+        return false;
+    }
+
+    int item = scene->num_buildings;
+    scene->buildings[scene->num_buildings++] = *b;
+    if (!id_index_insert(&scene->building_ids, &scene->id_arena, scene->buildings,
+                         sizeof(Building), item)) {
+        return false;
+    }
+
+    int level = building_level(b);
+    long long cx0 = ((long long)b->x - b->w) >> level, cx1 = ((long long)b->x + b->w) >> level;
+    long long cy0 = ((long long)b->y - b->h) >> level, cy1 = ((long long)b->y + b->h) >> level;
+    for (long long cx = cx0; cx <= cx1; cx++) {
+        for (long long cy = cy0; cy <= cy1; cy++) {
+            if (!grid_index_insert(&scene->building_grid, &scene->grid_arena, level, cx, cy, item) ||
+                !grid_summary_insert(&scene->building_grid, &scene->grid_arena, level, cx, cy)) {
+                return false;
+            }
+        }
+    }
+    scene->building_grid.level_counts[level]++;
+    stats.buildings++;
+    return true;
+}
+
+bool add_antenna(Scene* scene, const Antenna* a) {
+    if (scene->num_antennas == scene->antennas_capacity &&
+        !arena_grow_array(&scene->arena, (void**)&scene->antennas,
+                          &scene->antennas_capacity, sizeof(Antenna))) {
+        return false;
+    }
+
+    int item = scene->num_antennas;
+    scene->antennas[scene->num_antennas++] = *a;
+    if (!id_index_insert(&scene->antenna_ids, &scene->id_arena, scene->antennas,
+                         sizeof(Antenna), item)) {
+        return false;
+    }
+    if (!grid_index_insert(&scene->antenna_positions, &scene->grid_arena, 0, a->x, a->y, item)) {
+        return false;
+    }
+    scene->antenna_positions.level_counts[0]++;
+    if (rules.min_antenna_spacing > 0) {
+        int level = rules.spacing_level;
+        if (!grid_index_insert(&scene->antenna_spacing, &scene->grid_arena, level,
+                               (long long)a->x >> level, (long long)a->y >> level, item)) {
+            return false;
+        }
+        scene->antenna_spacing.level_counts[level]++;
+    }
+    stats.antennas++;
+    return true;
+}
+
+bool process_building(Scene* scene, const char* line, int line_num) {
+    Building building;
+    if (!parse_building_line(line, &building, line_num)) return false;
+    
+#ifdef KOVER_REFERENCE
+    if (reference_is_duplicate_building_id(scene, building.id)) {
+#else
+    if (is_duplicate_building_id(scene, building.id)) {
+#endif
+        fprintf(stderr, "error: building identifier %s is non unique\n", building.id);
+        return false;
+    }
+    
+#ifdef KOVER_REFERENCE
+    int other = reference_find_overlapping_building(scene, &building);
+#else
+    int other = find_overlapping_building(scene, &building);
+#endif
+    if (other >= 0) {
+        fprintf(stderr, "error: buildings %s and %s are overlapping\n", scene->buildings[other].id, building.id);
+        return false;
+    }
+    
+    if (!add_building(scene, &building)) {
+        print_error_memory();
+        return false;
+    }
+    return true;
+}
+
+bool process_antenna(Scene* scene, const char* line, int line_num) {
+    Antenna antenna;
+    if (!parse_antenna_line(line, &antenna, line_num)) return false;
+    
+#ifdef KOVER_REFERENCE
+    if (reference_is_duplicate_antenna_id(scene, antenna.id)) {
+#else
+    if (is_duplicate_antenna_id(scene, antenna.id)) {
+#endif
+        fprintf(stderr, "error: antenna identifier %s is non unique\n", antenna.id);
+        return false;
+    }
+    
+#ifdef KOVER_REFERENCE
+    int other = reference_find_antenna_at(scene, antenna.x, antenna.y);
+#else
+    int other = find_antenna_at(scene, antenna.x, antenna.y);
+#endif
+    if (other >= 0) {
+        fprintf(stderr, "error: antennas %s and %s have the same position\n", scene->antennas[other].id, antenna.id);
+        return false;
+    }
+    
+    if (rules.min_antenna_spacing > 0) {
+#ifdef KOVER_REFERENCE
+        other = reference_find_close_antenna(scene, &antenna);
+#else
+        other = find_close_antenna(scene, &antenna);
+#endif
+        if (other >= 0) {
+            fprintf(stderr, "error: antennas %s and %s are closer than %d\n",
+                    scene->antennas[other].id, antenna.id, rules.min_antenna_spacing);
+            return false;
+        }
+    }
+    
+    if (!add_antenna(scene, &antenna)) {
+        print_error_memory();
+        return false;
+    }
+    return true;
+}
+
+bool process_line(Scene* scene, char* line, int line_num) {
+    char type[MAX_ARG_LENGTH];
+    if (sscanf(line, " %10s ", type) != 1) {
+        print_error_line(line_num);
+        return false;
+    }
+
+    if (strcmp(type, "building") == 0) 
+        return process_building(scene, line, line_num);
+    else if (strcmp(type, "antenna") == 0) 
+        return process_antenna(scene, line, line_num);
+    
+    print_error_line(line_num);
+    return false;
+}
+
+bool read_line(FILE* input, char* line, int* line_num) {
+    if (!fgets(line, MAX_LINE_LENGTH, input)) return false;
+    (*line_num)++;
+    stats.lines++;
+    line[strcspn(line, "\n")] = 0;
+    return true;
+}
+
+bool read_scene(Scene* scene, const char* first_line, FILE* input, int* line_num) {
+    char line[MAX_LINE_LENGTH];
+    
+    KOVER_PROBE1(scene__load__start, *line_num);
+    if (!is_begin_scene(first_line)) {
+        fprintf(stderr, "error: first line must be exactly 'begin scene'\n");
+        KOVER_PROBE1(validation__failure, *line_num);
+        return false;
+    }
+    
+    while (read_line(input, line, line_num)) {
+        if (is_end_scene(line)) {
+            KOVER_PROBE3(scene__load__done, *line_num, scene->num_buildings, scene->num_antennas);
+            return true;
+        }
+        KOVER_PROBE2(line__parse, *line_num, line);
+        if (!process_line(scene, line, *line_num)) {
+            KOVER_PROBE1(validation__failure, *line_num);
+            return false;
+        }
+    }
+    
+    fprintf(stderr, "error: last line must be exactly 'end scene'\n");
+    KOVER_PROBE1(validation__failure, *line_num);
+    return false;
+}
+
+bool read_next_scene(FILE* input, char* line, int* line_num) {
+    while (read_line(input, line, line_num)) {
+        const char* c = line;
+        while (is_blank(*c)) c++;
+        if (*c) return true;
+    }
+    return false;
+}
+
+int process_stream(const char* subcommand, FILE* input, FILE* output, int jobs) {
+    if (jobs > 1) return process_stream_parallel(subcommand, input, output, jobs);
+
+    Scene scene;
+    init_scene(&scene);
+    
+    char line[MAX_LINE_LENGTH];
+    int line_num = 0;
+    int status = SUCCESS;
+    trace_event("process_stream", 'B');
+    bool more = read_line(input, line, &line_num);
+    if (!more) status = ERROR;
+    while (more) {
+        double start = now_seconds();
+        reset_scene(&scene);
+        trace_event("read_scene", 'B');
+        bool valid = read_scene(&scene, line, input, &line_num);
+        trace_event("read_scene", 'E');
+        if (!valid) {
+            status = ERROR;
+            break;
+        }
+        trace_event(subcommand, 'B');
+        KOVER_PROBE1(query__start, subcommand);
+        bool completed = run_subcommand(subcommand, &scene, output);
+        fflush(output);
+        KOVER_PROBE1(query__done, subcommand);
+        trace_event(subcommand, 'E');
+        record_scene_latency(now_seconds() - start);
+        if (!completed) {
+            status = ERROR;
+            break;
+        }
+        more = read_next_scene(input, line, &line_num);
+    }
+    trace_event("process_stream", 'E');
+    
+    free_scene(&scene);
+    return status;
+}
+
+int process_stream_parallel(const char* subcommand, FILE* input, FILE* output, int jobs) {
+    SceneJob* slots = kover_malloc(jobs * sizeof(SceneJob), MEM_SCENE);
+    if (!slots) {
+        print_error_memory();
+        return ERROR;
+    }
+    for (int k = 0; k < jobs; k++) {
+        init_scene(&slots[k].scene);
+        slots[k].subcommand = subcommand;
+        slots[k].results = (ByteBuffer){NULL, 0, 0, MEM_OUTPUT};
+        slots[k].tid = TRACE_TID + 1 + k;
+        slots[k].pending = false;
+    }
+
+    char line[MAX_LINE_LENGTH];
+    int line_num = 0;
+    int status = SUCCESS;
+    trace_event("process_stream", 'B');
+    bool more = read_line(input, line, &line_num);
+    if (!more) status = ERROR;
+    // Scene i goes to slot i % jobs, once the scene held by the slot is published
+    int next = 0;
+    bool failed = false;
+    while (more) {
+        SceneJob* job = &slots[next];
+        if (job->pending && !scene_job_finish(job, output)) {
+            failed = true;
+            break;
+        }
+        job->start = now_seconds();
+        reset_scene(&job->scene);
+        trace_event("read_scene", 'B');
+        bool valid = read_scene(&job->scene, line, input, &line_num);
+        trace_event("read_scene", 'E');
+        if (!valid || !scene_job_start(job)) {
+            status = ERROR;
+            break;
+        }
+        next = (next + 1) % jobs;
+        more = read_next_scene(input, line, &line_num);
+    }
+
+    // Scenes still pending, in stream order, the ones after a failed scene being dropped
+    for (int k = 0; k < jobs; k++) {
+        SceneJob* job = &slots[(next + k) % jobs];
+        if (job->pending && !scene_job_finish(job, failed ? NULL : output)) failed = true;
+    }
+    if (failed) status = ERROR;
+    trace_event("process_stream", 'E');
+
+    for (int k = 0; k < jobs; k++) {
+        kover_free(slots[k].results.data, slots[k].results.capacity, MEM_OUTPUT);
+        free_scene(&slots[k].scene);
+    }
+    kover_free(slots, jobs * sizeof(SceneJob), MEM_SCENE);
+    return status;
+}
+
+void scene_job_run(SceneJob* job) {
+    trace_event(job->subcommand, 'B');
+    KOVER_PROBE1(query__start, job->subcommand);
+    job->completed = run_subcommand(job->subcommand, &job->scene, job->output);
+    KOVER_PROBE1(query__done, job->subcommand);
+    trace_event(job->subcommand, 'E');
+    job->seconds = now_seconds() - job->start;
+}
+
+void* scene_job_thread(void* arg) {
+    SceneJob* job = arg;
+    trace_tid = job->tid;
+    scene_job_run(job);
+    job->stats = stats;
+    return NULL;
+}
+
+bool scene_job_start(SceneJob* job) {
+    job->results.size = 0;
+    job->output = byte_buffer_open(&job->results);
+    if (!job->output) {
+        print_error_memory();
+        return false;
+    }
+    memset(&job->stats, 0, sizeof(Stats));
+    job->threaded = pthread_create(&job->thread, NULL, scene_job_thread, job) == 0;
+    if (!job->threaded) scene_job_run(job);
+    job->pending = true;
+    return true;
+}
+
+bool scene_job_finish(SceneJob* job, FILE* output) {
+    if (job->threaded) pthread_join(job->thread, NULL);
+    job->pending = false;
+    merge_stats(&stats, &job->stats);
+    record_scene_latency(job->seconds);
+
+    bool rendered = !ferror(job->output);
+    if (fclose(job->output) != 0) rendered = false;
+    if (!output) return false;
+    if (job->completed && !rendered) print_error_memory();
+    fwrite(job->results.data, 1, job->results.size, output);
+    fflush(output);
+    return job->completed && rendered;
+}
+
+// --------------------------------------------------------
+// SECTION: WATCH MODE FUNCTIONS
+// --------------------------------------------------------
+
+unsigned long long hash_bytes(const char* data, size_t size) {
+    unsigned long long hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool byte_buffer_reserve(ByteBuffer* buffer, size_t extra) {
+    if (extra <= buffer->capacity - buffer->size) return true;
+    size_t capacity = buffer->capacity ? buffer->capacity : WATCH_BUFFER_SIZE;
+    while (extra > capacity - buffer->size) capacity *= 2;
+    char* data = kover_realloc(buffer->data, buffer->capacity, capacity, buffer->subsystem);
+    if (!data) return false;
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+ssize_t byte_buffer_write(void* cookie, const char* data, size_t size) {
+    ByteBuffer* buffer = cookie;
+    if (!byte_buffer_reserve(buffer, size)) return 0;
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+    return size;
+}
+
+FILE* byte_buffer_open(ByteBuffer* buffer) {
+    cookie_io_functions_t functions = {NULL, byte_buffer_write, NULL, NULL};
+    FILE* output = fopencookie(buffer, "w", functions);
+    if (output) setvbuf(output, NULL, _IONBF, 0);
+    return output;
+}
+
+bool read_file(const char* path, ByteBuffer* content) {
+    FILE* input = fopen(path, "r");
+    if (!input) return false;
+    size_t n;
+    do {
+        if (!byte_buffer_reserve(content, WATCH_BUFFER_SIZE)) {
+            print_error_memory();
+            fclose(input);
+            return false;
+        }
+        n = fread(content->data + content->size, 1, content->capacity - content->size, input);
+        content->size += n;
+    } while (n > 0);
+    fclose(input);
+    return true;
+}
+
+bool publish_version(const char* subcommand, FILE* input, ResultCache* cache,
+                     unsigned long long hash, int jobs) {
+    ByteBuffer results = {NULL, 0, 0, MEM_OUTPUT};
+    FILE* output = byte_buffer_open(&results);
+    if (!output) {
+        print_error_memory();
+        return false;
+    }
+
+    bool valid = process_stream(subcommand, input, output, jobs) == SUCCESS;
+    bool rendered = !ferror(output);
+    if (fclose(output) != 0) rendered = false;
+    if (valid && !rendered) print_error_memory();
+    if (valid && rendered) {
+        fwrite(results.data, 1, results.size, stdout);
+        fflush(stdout);
+        cache_store(cache, hash, results.data, results.size);
+    }
+    kover_free(results.data, results.capacity, MEM_OUTPUT);
+    return valid && rendered;
+}
+
+CacheEntry* cache_find(ResultCache* cache, unsigned long long hash) {
+    for (CacheEntry* entry = cache->head; entry; entry = entry->next) {
+        if (entry->hash != hash) continue;
+        if (entry != cache->head) {
+            cache_unlink(cache, entry);
+            entry->next = cache->head;
+            cache->head->prev = entry;
+            cache->head = entry;
+        }
+        stats.cache_hits++;
+        return entry;
+    }
+    stats.cache_misses++;
+    return NULL;
+}
+
+void cache_store(ResultCache* cache, unsigned long long hash, const char* results,
+                 size_t size) {
+    size_t bytes = sizeof(CacheEntry) + size;
+    if (bytes > cache->capacity) return;
+
+    while (cache->bytes + bytes > cache->capacity) {
+        CacheEntry* victim = cache->tail;
+        cache_unlink(cache, victim);
+        cache->bytes -= sizeof(CacheEntry) + victim->size;
+        kover_free(victim, sizeof(CacheEntry) + victim->size, MEM_CACHE);
+        stats.cache_evictions++;
+    }
+
+    CacheEntry* entry = kover_malloc(bytes, MEM_CACHE);
+    if (!entry) return;
+    entry->hash = hash;
+    entry->size = size;
+    memcpy(entry->results, results, size);
+
+    entry->prev = NULL;
+    entry->next = cache->head;
+    if (cache->head) cache->head->prev = entry;
+    else cache->tail = entry;
+    cache->head = entry;
+    cache->bytes += bytes;
+}
+
+void cache_unlink(ResultCache* cache, CacheEntry* entry) {
+    if (entry->prev) entry->prev->next = entry->next;
+    else cache->head = entry->next;
+    if (entry->next) entry->next->prev = entry->prev;
+    else cache->tail = entry->prev;
+}
+
+void cache_free(ResultCache* cache) {
+    while (cache->head) {
+        CacheEntry* entry = cache->head;
+        cache->head = entry->next;
+        kover_free(entry, sizeof(CacheEntry) + entry->size, MEM_CACHE);
+    }
+    cache->tail = NULL;
+    cache->bytes = 0;
+}
+
+int watch_file(const char* subcommand, const char* path, const Options* options) {
+    FILE* input = fopen(path, "r");
+    if (!input) {
+        print_error_file(path);
+        return ERROR;
+    }
+    fclose(input);
+
+    char dir_path[PATH_MAX], base_path[PATH_MAX];
+    snprintf(dir_path, sizeof(dir_path), "%s", path);
+    snprintf(base_path, sizeof(base_path), "%s", path);
+    const char* dir = dirname(dir_path);
+    const char* base = basename(base_path);
+
+    int fd = inotify_init();
+    if (fd < 0 || inotify_add_watch(fd, dir, WATCH_EVENTS) < 0) {
+        print_error_file(path);
+        if (fd >= 0) close(fd);
+        return ERROR;
+    }
+
+    ResultCache cache = {NULL, NULL, 0, options->cache_size};
+    unsigned long long last_hash = 0;
+    bool evaluated = false;
+    char events[WATCH_BUFFER_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    while (true) {
+        ByteBuffer content = {NULL, 0, 0, MEM_INPUT};
+        if (read_file(path, &content)) {
+            unsigned long long hash = hash_bytes(content.data, content.size);
+            if (!evaluated || hash != last_hash) {
+                // A version seen before is republished without being evaluated again
+                CacheEntry* cached = cache_find(&cache, hash);
+                if (cached) {
+                    fwrite(cached->results, 1, cached->size, stdout);
+                    fflush(stdout);
+                } else {
+                    input = fmemopen(content.data, content.size, "r");
+                    if (input) {
+                        publish_version(subcommand, input, &cache, hash, options->jobs);
+                        fclose(input);
+                    } else {
+                        print_error_memory();
+                    }
+                }
+                if (options->stats) print_stats(stderr);
+                if (options->trace_path) trace_write();
+                fflush(stderr);
+                last_hash = hash;
+                evaluated = true;
+            }
+        }
+        kover_free(content.data, content.capacity, MEM_INPUT);
+
+        bool changed = false;
+        while (!changed) {
+            ssize_t len = read(fd, events, sizeof(events));
+            if (len <= 0) {
+                cache_free(&cache);
+                close(fd);
+                return ERROR;
+            }
+            for (char* ptr = events; ptr < events + len;) {
+                const struct inotify_event* event = (const struct inotify_event*)ptr;
+                if (event->len > 0 && strcmp(event->name, base) == 0) changed = true;
+                ptr += sizeof(struct inotify_event) + event->len;
+            }
+        }
+    }
+}
+
+// --------------------------------------------------------
+// SECTION: SCENE COMPUTATION FUNCTIONS
+// --------------------------------------------------------
+
+bool is_omnidirectional(const Antenna* a) {
+    return a->beamwidth >= FULL_CIRCLE;
+}
+
+bool sector_contains_angle(const Antenna* a, int angle) {
+    if (is_omnidirectional(a)) return true;
+    int offset = ((angle - a->azimuth) % FULL_CIRCLE + FULL_CIRCLE) % FULL_CIRCLE;
+    if (offset > FULL_CIRCLE / 2) offset -= FULL_CIRCLE;
+    return 2 * abs(offset) <= a->beamwidth;
+}
+
+double snap_to_integer(double v) {
+    double rounded = round(v);
+    return fabs(v - rounded) < 1e-9 ? rounded : v;
+}
+
+void extend_bounds_on_circle(Antenna* a, double angle) {
+    double rad = angle * M_PI / 180.0;
+    double px = snap_to_integer(a->x + a->r * sin(rad));
+    double py = snap_to_integer(a->y + a->r * cos(rad));
+    if ((int)floor(px) < a->min_x) a->min_x = (int)floor(px);
+    if ((int)ceil(px) > a->max_x) a->max_x = (int)ceil(px);
+    if ((int)floor(py) < a->min_y) a->min_y = (int)floor(py);
+    if ((int)ceil(py) > a->max_y) a->max_y = (int)ceil(py);
+}
+
+void compute_antenna_bounds(Antenna* a) {
+    if (is_omnidirectional(a)) {
+        a->min_x = a->x - a->r;
+        a->max_x = a->x + a->r;
+        a->min_y = a->y - a->r;
+        a->max_y = a->y + a->r;
+        return;
+    }
+
+    a->min_x = a->max_x = a->x;
+    a->min_y = a->max_y = a->y;
+    extend_bounds_on_circle(a, a->azimuth - a->beamwidth / 2.0);
+    extend_bounds_on_circle(a, a->azimuth + a->beamwidth / 2.0);
+    for (int angle = 0; angle < FULL_CIRCLE; angle += FULL_CIRCLE / 4) {
+        if (sector_contains_angle(a, angle)) extend_bounds_on_circle(a, angle);
+    }
+}
+
+void compute_bounding_box(const Scene* scene, int* min_x, int* max_x, int* min_y, int* max_y) {
+    *min_x = INT_MAX;
+    *max_x = INT_MIN;
+    *min_y = INT_MAX;
+    *max_y = INT_MIN;
+
+    for (int i = 0; i < scene->num_buildings; i++) {
+        const Building* b = &scene->buildings[i];
+        if (b->x - b->w < *min_x) *min_x = b->x - b->w;
+        if (b->x + b->w > *max_x) *max_x = b->x + b->w;
+        if (b->y - b->h < *min_y) *min_y = b->y - b->h;
+        if (b->y + b->h > *max_y) *max_y = b->y + b->h;
+    }
+
+    for (int i = 0; i < scene->num_antennas; i++) {
+        const Antenna* a = &scene->antennas[i];
+        if (a->min_x < *min_x) *min_x = a->min_x;
+        if (a->max_x > *max_x) *max_x = a->max_x;
+        if (a->min_y < *min_y) *min_y = a->min_y;
+        if (a->max_y > *max_y) *max_y = a->max_y;
+    }
+}
+
+bool antenna_covers_point(const Antenna* a, long long px, long long py) {
+    long long dx = px - a->x, dy = py - a->y;
+    if (dx * dx + dy * dy > (long long)a->r * a->r) return false;
+    if (is_omnidirectional(a) || (dx == 0 && dy == 0)) return true;
+
+    double angle = atan2((double)dx, (double)dy) * 180.0 / M_PI;
+    double offset = fmod(angle - a->azimuth, FULL_CIRCLE);
+    if (offset > FULL_CIRCLE / 2) offset -= FULL_CIRCLE;
+    if (offset < -FULL_CIRCLE / 2) offset += FULL_CIRCLE;
+    return 2 * fabs(offset) <= a->beamwidth + 1e-9;
+}
+
+bool segment_enters_blind_cone(const Antenna* a, double px, double py, double qx, double qy) {
+    // The blind cone lies clockwise of the first edge and counterclockwise of the second
+    double first = (a->azimuth + a->beamwidth / 2.0) * M_PI / 180.0;
+    double second = (a->azimuth - a->beamwidth / 2.0) * M_PI / 180.0;
+    double e1x = sin(first), e1y = cos(first);
+    double e2x = sin(second), e2y = cos(second);
+    px -= a->x; py -= a->y;
+    qx -= a->x; qy -= a->y;
+
+    // Both conditions are linear in t along P + t (Q - P), t in [0, 1]
+    double c1 = e1x * py - e1y * px, d1 = (e1x * qy - e1y * qx) - c1;
+    double c2 = e2x * py - e2y * px, d2 = (e2x * qy - e2y * qx) - c2;
+    double low = 0.0, high = 1.0, eps = 1e-9;
+
+    // c1 + t d1 < 0
+    if (fabs(d1) < eps) {
+        if (c1 >= -eps) return false;
+    } else if (d1 > 0) {
+        if (-c1 / d1 < high) high = -c1 / d1;
+    } else if (-c1 / d1 > low) {
+        low = -c1 / d1;
+    }
+    // c2 + t d2 > 0
+    if (fabs(d2) < eps) {
+        if (c2 <= eps) return false;
+    } else if (d2 > 0) {
+        if (-c2 / d2 > low) low = -c2 / d2;
+    } else if (-c2 / d2 < high) {
+        high = -c2 / d2;
+    }
+    return high - low > eps;
+}
+
+bool antenna_covers_building(const Antenna* a, const Building* b) {
+    long long x0 = (long long)b->x - b->w, x1 = (long long)b->x + b->w;
+    long long y0 = (long long)b->y - b->h, y1 = (long long)b->y + b->h;
+    if (!antenna_covers_point(a, x0, y0) || !antenna_covers_point(a, x1, y0) ||
+        !antenna_covers_point(a, x1, y1) || !antenna_covers_point(a, x0, y1)) {
+        return false;
+    }
+    if (a->beamwidth <= FULL_CIRCLE / 2 || is_omnidirectional(a)) return true;
+
+    return !segment_enters_blind_cone(a, x0, y0, x1, y0) &&
+           !segment_enters_blind_cone(a, x1, y0, x1, y1) &&
+           !segment_enters_blind_cone(a, x1, y1, x0, y1) &&
+           !segment_enters_blind_cone(a, x0, y1, x0, y0);
+}
+
+long long point_coordinate(const NeighbourPoint* p, int axis) {
+    return axis == 0 ? p->x : p->y;
+}
+
+void kd_tree_select(KdTree* tree, int lo, int hi, int k, int axis) {
+    int* order = tree->order;
+    while (hi - lo > 1) {
+        long long pivot = point_coordinate(&tree->points[order[lo + (hi - lo) / 2]], axis);
+        // order[lo, lt) < pivot, order[lt, i) == pivot, order[gt, hi) > pivot
+        int lt = lo, i = lo, gt = hi;
+        while (i < gt) {
+            long long c = point_coordinate(&tree->points[order[i]], axis);
+            int tmp = order[i];
+            if (c < pivot) {
+                order[i++] = order[lt];
+                order[lt++] = tmp;
+            } else if (c > pivot) {
+                order[i] = order[--gt];
+                order[gt] = tmp;
+            } else {
+                i++;
+            }
+        }
+        if (k < lt) hi = lt;
+        else if (k >= gt) lo = gt;
+        else return;
+    }
+}
+
+void kd_tree_build(KdTree* tree, int lo, int hi) {
+    while (hi - lo > 1) {
+        long long min_x = LLONG_MAX, max_x = LLONG_MIN, min_y = LLONG_MAX, max_y = LLONG_MIN;
+        for (int k = lo; k < hi; k++) {
+            const NeighbourPoint* p = &tree->points[tree->order[k]];
+            if (p->x < min_x) min_x = p->x;
+            if (p->x > max_x) max_x = p->x;
+            if (p->y < min_y) min_y = p->y;
+            if (p->y > max_y) max_y = p->y;
+        }
+        int mid = lo + (hi - lo) / 2;
+        int axis = max_x - min_x >= max_y - min_y ? 0 : 1;
+        tree->axes[mid] = axis;
+        kd_tree_select(tree, lo, hi, mid, axis);
+        // Recursion on the smaller side keeps the stack logarithmic
+        if (mid - lo < hi - mid - 1) {
+            kd_tree_build(tree, lo, mid);
+            lo = mid + 1;
+        } else {
+            kd_tree_build(tree, mid + 1, hi);
+            hi = mid;
+        }
+    }
+}
+
+void kd_tree_nearest(const KdTree* tree, int lo, int hi, int i, int* best,
+                     long long* best_d2) {
+    if (lo >= hi) return;
+    int mid = lo + (hi - lo) / 2;
+    int j = tree->order[mid];
+    const NeighbourPoint* p = &tree->points[i];
+    const NeighbourPoint* q = &tree->points[j];
+    stats.grid_visits++;
+
+    long long dx = (long long)q->x - p->x, dy = (long long)q->y - p->y;
+    long long d2 = dx * dx + dy * dy;
+    if (j != i && (d2 < *best_d2 || (d2 == *best_d2 && j < *best))) {
+        *best = j;
+        *best_d2 = d2;
+    }
+    if (hi - lo == 1) return;
+
+    int axis = tree->axes[mid];
+    long long gap = point_coordinate(p, axis) - point_coordinate(q, axis);
+    if (gap < 0) {
+        kd_tree_nearest(tree, lo, mid, i, best, best_d2);
+        if (gap * gap <= *best_d2) kd_tree_nearest(tree, mid + 1, hi, i, best, best_d2);
+    } else {
+        kd_tree_nearest(tree, mid + 1, hi, i, best, best_d2);
+        if (gap * gap <= *best_d2) kd_tree_nearest(tree, lo, mid, i, best, best_d2);
+    }
+}
+
+bool find_nearest_neighbours(NeighbourPoint* points, int n) {
+    if (n == 0) return true;
+
+    KdTree tree;
+    tree.points = points;
+    tree.order = kover_malloc(n * sizeof(int), MEM_GRID_INDEX);
+    tree.axes = kover_malloc(n, MEM_GRID_INDEX);
+    if (!tree.order || !tree.axes) {
+        kover_free(tree.order, n * sizeof(int), MEM_GRID_INDEX);
+        kover_free(tree.axes, n, MEM_GRID_INDEX);
+        return false;
+    }
+    for (int i = 0; i < n; i++) tree.order[i] = i;
+    kd_tree_build(&tree, 0, n);
+
+    for (int i = 0; i < n; i++) {
+        NeighbourPoint* p = &points[i];
+        long long best_d2 = LLONG_MAX;
+        int best = -1;
+        stats.grid_lookups++;
+        kd_tree_nearest(&tree, 0, n, i, &best, &best_d2);
+        p->nearest = best;
+        p->distance = best < 0 ? 0 : sqrt((double)best_d2);
+    }
+    kover_free(tree.order, n * sizeof(int), MEM_GRID_INDEX);
+    kover_free(tree.axes, n, MEM_GRID_INDEX);
+    return true;
+}
+
+int compare_hull_points(const void* a, const void* b) {
+    const HullPoint* p = a;
+    const HullPoint* q = b;
+    if (p->x != q->x) return p->x < q->x ? -1 : 1;
+    if (p->y != q->y) return p->y < q->y ? -1 : 1;
+    return 0;
+}
+
+double cross_product(const HullPoint* o, const HullPoint* a, const HullPoint* b) {
+    return (a->x - o->x) * (b->y - o->y) - (a->y - o->y) * (b->x - o->x);
+}
+
+int collect_hull_points(const Scene* scene, int sides, HullPoint* points) {
+    int n = 0;
+    for (unsigned int i = 0; i < scene->num_buildings; i++) {
+        const Building* b = &scene->buildings[i];
+        points[n++] = (HullPoint){(double)b->x - b->w, (double)b->y - b->h};
+        points[n++] = (HullPoint){(double)b->x + b->w, (double)b->y - b->h};
+        points[n++] = (HullPoint){(double)b->x + b->w, (double)b->y + b->h};
+        points[n++] = (HullPoint){(double)b->x - b->w, (double)b->y + b->h};
+    }
+    // Circumscribed polygons contain their disk
+    double scale = 1 / cos(M_PI / sides);
+    for (unsigned int i = 0; i < scene->num_antennas; i++) {
+        const Antenna* a = &scene->antennas[i];
+        if (is_omnidirectional(a)) {
+            for (int k = 0; k < sides; k++) {
+                double angle = 2 * M_PI * k / sides;
+                points[n++] = (HullPoint){a->x + a->r * scale * cos(angle),
+                                          a->y + a->r * scale * sin(angle)};
+            }
+            continue;
+        }
+        // Angles clockwise from north; the arc is split in arcs of at most
+        // 360 / sides degrees, whose tangents at their ends meet outside it
+        double start = (a->azimuth - a->beamwidth / 2.0) * M_PI / 180;
+        double span = a->beamwidth * M_PI / 180;
+        int arcs = (int)ceil(sides * a->beamwidth / (double)FULL_CIRCLE);
+        if (arcs < 1) arcs = 1;
+        double step = span / arcs, outer = a->r / cos(step / 2);
+        points[n++] = (HullPoint){a->x, a->y};
+        points[n++] = (HullPoint){a->x + a->r * sin(start), a->y + a->r * cos(start)};
+        points[n++] = (HullPoint){a->x + a->r * sin(start + span),
+                                  a->y + a->r * cos(start + span)};
+        for (int k = 0; k < arcs; k++) {
+            double angle = start + (k + 0.5) * step;
+            points[n++] = (HullPoint){a->x + outer * sin(angle), a->y + outer * cos(angle)};
+        }
+    }
+    return n;
+}
+
+double project_point(const HullPoint* p, const HullPoint* origin, double dx, double dy) {
+    return (p->x - origin->x) * dx + (p->y - origin->y) * dy;
+}
+
+bool outside_circle(const HullPoint* p, const HullPoint* center, double radius) {
+    // Relative tolerance so that the points defining the circle stay inside
+    return hypot(p->x - center->x, p->y - center->y) > radius * (1 + 1e-12) + 1e-9;
+}
+
+int convex_hull(HullPoint* points, int n, HullPoint* hull) {
+    qsort(points, n, sizeof(HullPoint), compare_hull_points);
+    if (n < 3) {
+        memcpy(hull, points, n * sizeof(HullPoint));
+        return n;
+    }
+
+    int h = 0;
+    for (int i = 0; i < n; i++) {
+        while (h >= 2 && cross_product(&hull[h - 2], &hull[h - 1], &points[i]) <= 0) h--;
+        hull[h++] = points[i];
+    }
+    for (int i = n - 2, lower = h + 1; i >= 0; i--) {
+        while (h >= lower && cross_product(&hull[h - 2], &hull[h - 1], &points[i]) <= 0) h--;
+        hull[h++] = points[i];
+    }
+    return h - 1;
+}
+
+double minimum_area_rectangle(const HullPoint* hull, int h, HullPoint corners[4]) {
+    double best = INFINITY;
+    int far = 1, top = 1, back = 1;
+
+    for (int i = 0; i < h; i++) {
+        const HullPoint* p = &hull[i];
+        const HullPoint* q = &hull[(i + 1) % h];
+        double length = hypot(q->x - p->x, q->y - p->y);
+        double ux = (q->x - p->x) / length, uy = (q->y - p->y) / length;
+        // The polygon is on the left of its counterclockwise edges
+        double nx = -uy, ny = ux;
+
+        if (i == 0) far = 1;
+        for (int steps = 0; steps < h && project_point(&hull[(far + 1) % h], p, ux, uy) >=
+                                         project_point(&hull[far % h], p, ux, uy); steps++) far++;
+        if (i == 0) top = far;
+        for (int steps = 0; steps < h && project_point(&hull[(top + 1) % h], p, nx, ny) >=
+                                         project_point(&hull[top % h], p, nx, ny); steps++) top++;
+        if (i == 0) back = top;
+        for (int steps = 0; steps < h && project_point(&hull[(back + 1) % h], p, ux, uy) <=
+                                         project_point(&hull[back % h], p, ux, uy); steps++) back++;
+
+        double min_u = project_point(&hull[back % h], p, ux, uy);
+        double max_u = project_point(&hull[far % h], p, ux, uy);
+        double height = project_point(&hull[top % h], p, nx, ny);
+        double area = (max_u - min_u) * height;
+        if (area < best) {
+            best = area;
+            double ox = p->x + ux * min_u, oy = p->y + uy * min_u;
+            double width = max_u - min_u;
+            corners[0] = (HullPoint){ox, oy};
+            corners[1] = (HullPoint){ox + ux * width, oy + uy * width};
+            corners[2] = (HullPoint){ox + ux * width + nx * height, oy + uy * width + ny * height};
+            corners[3] = (HullPoint){ox + nx * height, oy + ny * height};
+        }
+    }
+    return best;
+}
+
+double minimum_enclosing_circle(HullPoint* points, int n, HullPoint* center) {
+    // Deterministic shuffle (linear congruential generator) for the expected bound
+    unsigned long long state = 0x9E3779B97F4A7C15ull;
+    for (int i = n - 1; i > 0; i--) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        int j = (int)((state >> 33) % (unsigned long long)(i + 1));
+        HullPoint tmp = points[i];
+        points[i] = points[j];
+        points[j] = tmp;
+    }
+
+    HullPoint c = points[0];
+    double r = 0;
+    for (int i = 1; i < n; i++) {
+        if (!outside_circle(&points[i], &c, r)) continue;
+        c = points[i];
+        r = 0;
+        for (int j = 0; j < i; j++) {
+            if (!outside_circle(&points[j], &c, r)) continue;
+            c = (HullPoint){(points[i].x + points[j].x) / 2, (points[i].y + points[j].y) / 2};
+            r = hypot(points[i].x - c.x, points[i].y - c.y);
+            for (int k = 0; k < j; k++) {
+                if (!outside_circle(&points[k], &c, r)) continue;
+                // Circle through the three points
+                const HullPoint* a = &points[i];
+                const HullPoint* b = &points[j];
+                const HullPoint* d = &points[k];
+                double bx = b->x - a->x, by = b->y - a->y;
+                double dx = d->x - a->x, dy = d->y - a->y;
+                double det = 2 * (bx * dy - by * dx);
+                if (det == 0) continue;
+                double b2 = bx * bx + by * by, d2 = dx * dx + dy * dy;
+                c = (HullPoint){a->x + (dy * b2 - by * d2) / det, a->y + (bx * d2 - dx * b2) / det};
+                r = hypot(a->x - c.x, a->y - c.y);
+            }
+        }
+    }
+    *center = c;
+    return r;
+}
+
+// --------------------------------------------------------
+// SECTION: COVER SOLVER FUNCTIONS
+// --------------------------------------------------------
+
+int bitset_and_count(const uint64_t* a, const uint64_t* b, int words) {
+    int count = 0;
+    for (int w = 0; w < words; w++) count += __builtin_popcountll(a[w] & b[w]);
+    return count;
+}
+
+bool cover_search_init(const Scene* scene, CoverSearch* search, bool weighted, bool dense,
+                       int* uncoverable) {
+    int n = scene->num_buildings, m = scene->num_antennas;
+    int words = (n + 63) / 64;
+    memset(search, 0, sizeof(CoverSearch));
+    search->num_buildings = n;
+    search->num_antennas = m;
+    search->words = words;
+    *uncoverable = -1;
+
+    // Every array has one extra element so that empty scenes allocate something
+    search->candidates = kover_malloc((m + 1) * sizeof(int), MEM_SOLVER);
+    search->set_offsets = kover_malloc((m + 1) * sizeof(int), MEM_SOLVER);
+    search->building_offsets = kover_malloc((n + 1) * sizeof(int), MEM_SOLVER);
+    search->current = kover_malloc((n + 1) * sizeof(int), MEM_SOLVER);
+    search->best = kover_malloc((n + 1) * sizeof(int), MEM_SOLVER);
+    search->marks = kover_malloc((m + 1) * sizeof(int), MEM_SOLVER);
+    search->excluded = kover_malloc((m + 1) * sizeof(int), MEM_SOLVER);
+    search->counts = kover_malloc((n + 1) * sizeof(int), MEM_SOLVER);
+    search->pending = kover_malloc((n + 1) * sizeof(int), MEM_SOLVER);
+    if (!search->candidates || !search->set_offsets || !search->building_offsets ||
+        !search->current || !search->best || !search->marks || !search->excluded ||
+        !search->counts || !search->pending) {
+        cover_search_free(search);
+        return false;
+    }
+
+    // Only the buildings within the box of an antenna may be covered by it
+    int* found = search->current;
+    int* set_offsets = search->set_offsets;
+    int total = 0;
+    set_offsets[0] = 0;
+    for (int i = 0; i < m; i++) {
+        const Antenna* a = &scene->antennas[i];
+        int count = find_buildings_in_box(scene, a->min_x, a->max_x, a->min_y, a->max_y, found);
+        if (count > search->memberships_capacity - total) {
+            int capacity = search->memberships_capacity ? search->memberships_capacity : 64;
+            while (count > capacity - total && capacity <= INT_MAX / 2) capacity *= 2;
+            int* grown = count > capacity - total ? NULL : kover_realloc(
+                search->set_buildings, search->memberships_capacity * sizeof(int),
+                capacity * sizeof(int), MEM_SOLVER);
+            if (!grown) {
+                cover_search_free(search);
+                return false;
+            }
+            search->set_buildings = grown;
+            search->memberships_capacity = capacity;
+        }
+        for (int k = 0; k < count; k++) {
+            if (antenna_covers_building(a, &scene->buildings[found[k]])) {
+                search->set_buildings[total++] = found[k];
+            }
+        }
+        set_offsets[i + 1] = total;
+    }
+    int* set_buildings = search->set_buildings;
+
+    // Antennas covering each building, grouped by building
+    search->building_candidates = kover_malloc((search->memberships_capacity + 1) * sizeof(int),
+                                               MEM_SOLVER);
+    if (!search->building_candidates) {
+        cover_search_free(search);
+        return false;
+    }
+    int* offsets = search->building_offsets;
+    int* lists = search->building_candidates;
+    memset(offsets, 0, (n + 1) * sizeof(int));
+    for (int k = 0; k < total; k++) offsets[set_buildings[k] + 1]++;
+    for (int b = 0; b < n; b++) offsets[b + 1] += offsets[b];
+    int* next = search->current;
+    memcpy(next, offsets, n * sizeof(int));
+    for (int i = 0; i < m; i++) {
+        for (int k = set_offsets[i]; k < set_offsets[i + 1]; k++) {
+            lists[next[set_buildings[k]]++] = i;
+        }
+    }
+
+    // Dominance pruning: drop empty sets and subsets, keeping the first of equal sets
+    // (when weighted, only for antennas whose radius is not smaller)
+    int* stamps = search->counts;
+    long long work = 0;
+    memset(stamps, 0, (n + 1) * sizeof(int));
+    for (int i = 0; i < m; i++) {
+        int size_i = set_offsets[i + 1] - set_offsets[i];
+        bool dominated = size_i == 0;
+        if (!dominated && work < COVER_DOMINANCE_WORK) {
+            int pivot = set_buildings[set_offsets[i]];
+            for (int k = set_offsets[i]; k < set_offsets[i + 1]; k++) {
+                int b = set_buildings[k];
+                stamps[b] = i + 1;
+                if (offsets[b + 1] - offsets[b] < offsets[pivot + 1] - offsets[pivot]) pivot = b;
+            }
+            work += size_i;
+            for (int l = offsets[pivot]; l < offsets[pivot + 1] && !dominated; l++) {
+                int j = lists[l];
+                int size_j = set_offsets[j + 1] - set_offsets[j];
+                if (j == i || size_j < size_i) continue;
+                int shared = 0;
+                for (int k = set_offsets[j]; k < set_offsets[j + 1]; k++) {
+                    if (stamps[set_buildings[k]] == i + 1) shared++;
+                }
+                work += size_j;
+                if (shared != size_i) continue;
+                int ri = scene->antennas[i].r, rj = scene->antennas[j].r;
+                if (weighted && ri != rj) {
+                    dominated = rj < ri;
+                } else {
+                    dominated = j < i || size_j > size_i;
+                }
+            }
+        }
+        search->marks[i] = dominated ? -1 : search->num_candidates;
+        if (!dominated) search->candidates[search->num_candidates++] = i;
+    }
 
-bool is_blank(char c) {
-    return c == ' ' || c == '\t';
-}
+    // Lists of the candidates only, in place since candidates keep their order
+    total = 0;
+    for (int c = 0; c < search->num_candidates; c++) {
+        int i = search->candidates[c];
+        int first = set_offsets[i], last = set_offsets[i + 1];
+        set_offsets[c] = total;
+        memmove(&set_buildings[total], &set_buildings[first], (last - first) * sizeof(int));
+        total += last - first;
+    }
+    set_offsets[search->num_candidates] = total;
+    total = 0;
+    for (int b = 0; b < n; b++) {
+        int first = offsets[b], last = offsets[b + 1];
+        offsets[b] = total;
+        for (int l = first; l < last; l++) {
+            if (search->marks[lists[l]] >= 0) lists[total++] = search->marks[lists[l]];
+        }
+        if (total == offsets[b] && *uncoverable < 0) *uncoverable = b;
+    }
+    offsets[n] = total;
+    search->num_memberships = total;
 
-bool is_valid_id_char(char c, bool first) {
-    if (first) 
-        return isalpha(c) || c == '_';
-    return isalnum(c) || c == '_';
-}
+    memset(search->marks, 0, (m + 1) * sizeof(int));
+    memset(search->excluded, 0, (m + 1) * sizeof(int));
+    if (!dense || (size_t)(search->num_candidates + n + 1) * words > COVER_DENSE_WORDS) {
+        return true;
+    }
 
-bool is_valid_id(const char* id) {
-    if (!id[0]) return false;
-    if (!is_valid_id_char(id[0], true)) return false;
-    
-    for (int i = 1; id[i]; i++) {
-        if (!is_valid_id_char(id[i], false)) return false;
+    // Bitsets of the exact search
+    search->sets = kover_malloc(((size_t)search->num_candidates * words + 1) * sizeof(uint64_t),
+                                MEM_SOLVER);
+    search->uncovered = kover_malloc(((size_t)(n + 1) * words + 1) * sizeof(uint64_t), MEM_SOLVER);
+    // The branching buildings of a path are distinct, so its branches fit in one stack
+    search->branch_order = kover_malloc((total + 1) * sizeof(int), MEM_SOLVER);
+    search->branch_gains = kover_malloc((total + 1) * sizeof(int), MEM_SOLVER);
+    search->branch_top = 0;
+    if (!search->sets || !search->uncovered || !search->branch_order || !search->branch_gains) {
+        cover_search_free(search);
+        return false;
+    }
+    memset(search->sets, 0, (size_t)search->num_candidates * words * sizeof(uint64_t));
+    for (int c = 0; c < search->num_candidates; c++) {
+        for (int k = set_offsets[c]; k < set_offsets[c + 1]; k++) {
+            int b = set_buildings[k];
+            search->sets[(size_t)c * words + b / 64] |= 1ULL << (b % 64);
+        }
     }
+    memset(search->uncovered, 0, words * sizeof(uint64_t));
+    for (int b = 0; b < n; b++) search->uncovered[b / 64] |= 1ULL << (b % 64);
     return true;
 }
 
-bool is_valid_integer(const char* str) {
-    if (!str[0]) return false;
-    if (str[0] == '0' && str[1]) return false;
-    
-    int start = (str[0] == '-') ? 1 : 0;
-    if (start == 1 && !str[1]) return false;
-    
-    for (int i = start; str[i]; i++) {
-        if (!isdigit(str[i])) return false;
-    }
-    return true;
+void cover_search_free(CoverSearch* search) {
+    int n = search->num_buildings, m = search->num_antennas, words = search->words;
+    kover_free(search->candidates, (m + 1) * sizeof(int), MEM_SOLVER);
+    kover_free(search->set_offsets, (m + 1) * sizeof(int), MEM_SOLVER);
+    kover_free(search->set_buildings, search->memberships_capacity * sizeof(int), MEM_SOLVER);
+    kover_free(search->building_offsets, (n + 1) * sizeof(int), MEM_SOLVER);
+    kover_free(search->building_candidates, (search->memberships_capacity + 1) * sizeof(int),
+               MEM_SOLVER);
+    kover_free(search->sets, ((size_t)search->num_candidates * words + 1) * sizeof(uint64_t),
+               MEM_SOLVER);
+    kover_free(search->uncovered, ((size_t)(n + 1) * words + 1) * sizeof(uint64_t), MEM_SOLVER);
+    kover_free(search->branch_order, (search->num_memberships + 1) * sizeof(int), MEM_SOLVER);
+    kover_free(search->branch_gains, (search->num_memberships + 1) * sizeof(int), MEM_SOLVER);
+    kover_free(search->current, (n + 1) * sizeof(int), MEM_SOLVER);
+    kover_free(search->best, (n + 1) * sizeof(int), MEM_SOLVER);
+    kover_free(search->marks, (m + 1) * sizeof(int), MEM_SOLVER);
+    kover_free(search->excluded, (m + 1) * sizeof(int), MEM_SOLVER);
+    kover_free(search->counts, (n + 1) * sizeof(int), MEM_SOLVER);
+    kover_free(search->pending, (n + 1) * sizeof(int), MEM_SOLVER);
+    memset(search, 0, sizeof(CoverSearch));
 }
 
-bool is_valid_positive_integer(const char* str) {
-    if (!str[0] || str[0] == '-' || str[0] == '0') return false;
-    
-    for (int i = 0; str[i]; i++) {
-        if (!isdigit(str[i])) return false;
+void cover_greedy(CoverSearch* search) {
+    int words = search->words;
+    uint64_t* uncovered = search->uncovered + words;
+    memcpy(uncovered, search->uncovered, words * sizeof(uint64_t));
+    search->best_size = 0;
+
+    while (true) {
+        int chosen = -1, chosen_gain = 0;
+        for (int c = 0; c < search->num_candidates; c++) {
+            int gain = bitset_and_count(&search->sets[(size_t)c * words], uncovered, words);
+            if (gain > chosen_gain) {
+                chosen = c;
+                chosen_gain = gain;
+            }
+        }
+        if (chosen < 0) return;
+        search->best[search->best_size++] = chosen;
+        const uint64_t* set = &search->sets[(size_t)chosen * words];
+        for (int w = 0; w < words; w++) uncovered[w] &= ~set[w];
     }
-    return true;
 }
 
-bool is_valid_subcommand(const char* subcommand) {
-    for (int i = 0; i < NUM_SUBCOMMANDS; i++) {
-        if (strcmp(subcommand, VALID_SUBCOMMANDS[i]) == 0) return true;
+void cover_branch(CoverSearch* search, int depth) {
+    int words = search->words;
+    const uint64_t* uncovered = search->uncovered + (size_t)depth * words;
+    if (search->nodes_left == 0) {
+        search->stopped = true;
+        return;
     }
-    return false;
-}
+    search->nodes_left--;
+    int remaining = bitset_and_count(uncovered, uncovered, words);
+    stats.cover_nodes++;
 
-bool is_begin_scene(const char* line) {
-    return strcmp(line, "begin scene") == 0;
-}
+    if (remaining == 0) {
+        memcpy(search->best, search->current, depth * sizeof(int));
+        search->best_size = depth;
+        return;
+    }
+    if (depth + 1 >= search->best_size) return;
 
-bool is_end_scene(const char* line) {
-    return strcmp(line, "end scene") == 0;
-}
+    int max_gain = 0;
+    for (int c = 0; c < search->num_candidates; c++) {
+        if (search->excluded[c]) continue;
+        int gain = bitset_and_count(&search->sets[(size_t)c * words], uncovered, words);
+        if (gain > max_gain) max_gain = gain;
+    }
+    if (max_gain == 0) return;
+    if (depth + (remaining + max_gain - 1) / max_gain >= search->best_size) return;
 
-void trim_line(char* line) {
-    char* end = line + strlen(line) - 1;
-    while (end > line && is_blank(*end)) end--;
-    *(end + 1) = '\0';
-    
-    while (*line && is_blank(*line)) line++;
-}
+    // Branch on the uncovered building with the fewest candidates
+    int building = -1, fewest = INT_MAX;
+    int* pending = search->pending;
+    int num_pending = 0;
+    for (int w = 0; w < words; w++) {
+        for (uint64_t bits = uncovered[w]; bits; bits &= bits - 1) {
+            int b = w * 64 + __builtin_ctzll(bits);
+            int count = 0;
+            for (int k = search->building_offsets[b]; k < search->building_offsets[b + 1]; k++) {
+                if (!search->excluded[search->building_candidates[k]]) count++;
+            }
+            if (count == 0) return;
+            if (count < fewest) {
+                building = b;
+                fewest = count;
+            }
+            search->counts[b] = count;
+            pending[num_pending++] = b;
+        }
+    }
 
-// --------------------------------------------------------
-// SECTION: ERROR HANDLING FUNCTIONS
-// --------------------------------------------------------
+    // Uncovered buildings sharing no candidate each need their own antenna.
+    // Buildings with few candidates block few others, so they are packed first.
+    int disjoint = 0;
+    search->stamp++;
+    for (int limit = fewest; num_pending > 0; limit++) {
+        int kept = 0;
+        for (int p = 0; p < num_pending; p++) {
+            int b = pending[p];
+            if (search->counts[b] > limit) {
+                pending[kept++] = b;
+                continue;
+            }
+            int first = search->building_offsets[b], last = search->building_offsets[b + 1];
+            bool shared = false;
+            for (int k = first; k < last && !shared; k++) {
+                int c = search->building_candidates[k];
+                shared = !search->excluded[c] && search->marks[c] == search->stamp;
+            }
+            if (shared) continue;
+            disjoint++;
+            for (int k = first; k < last; k++) {
+                search->marks[search->building_candidates[k]] = search->stamp;
+            }
+        }
+        num_pending = kept;
+    }
+    if (depth + disjoint >= search->best_size) return;
 
-void print_error_line(int line_num) {
-    fprintf(stderr, "error: unrecognized line (line #%d)\n", line_num);
-}
+    // Candidates covering it, by decreasing gain (insertion sort, lists are short)
+    int first = search->building_offsets[building], last = search->building_offsets[building + 1];
+    int* order = search->branch_order + search->branch_top;
+    int* gains = search->branch_gains + search->branch_top;
+    int count = 0;
+    for (int k = first; k < last; k++) {
+        int c = search->building_candidates[k];
+        if (search->excluded[c]) continue;
+        int gain = bitset_and_count(&search->sets[(size_t)c * words], uncovered, words);
+        int pos = count++;
+        while (pos > 0 && gains[pos - 1] < gain) {
+            order[pos] = order[pos - 1];
+            gains[pos] = gains[pos - 1];
+            pos--;
+        }
+        order[pos] = c;
+        gains[pos] = gain;
+    }
 
-void print_error_mandatory() {
-    fprintf(stderr, "error: subcommand is mandatory\n");
+    // Covers using a candidate were all explored by its branch: later branches exclude it
+    uint64_t* next = search->uncovered + (size_t)(depth + 1) * words;
+    int explored = 0;
+    search->branch_top += count;
+    for (int k = 0; k < count && depth + 1 < search->best_size && !search->stopped; k++) {
+        const uint64_t* set = &search->sets[(size_t)order[k] * words];
+        for (int w = 0; w < words; w++) next[w] = uncovered[w] & ~set[w];
+        search->current[depth] = order[k];
+        cover_branch(search, depth + 1);
+        search->excluded[order[k]]++;
+        explored++;
+    }
+    search->branch_top -= count;
+    for (int k = 0; k < explored; k++) search->excluded[order[k]]--;
 }
 
-void print_error_unrecognized(const char* subcommand) {
-    fprintf(stderr, "error: subcommand '%s' is not recognized\n", subcommand);
+void heap_push(HeapEntry* heap, int* size, double priority, int item) {
+    int pos = (*size)++;
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (heap[parent].priority > priority ||
+            (heap[parent].priority == priority && heap[parent].item < item)) break;
+        heap[pos] = heap[parent];
+        pos = parent;
+    }
+    heap[pos].priority = priority;
+    heap[pos].item = item;
 }
 
-void print_help() {
-    printf("Usage: kover SUBCOMMAND\n");
-    printf("Handles positioning of communication antennas by reading a scene on stdin.\n\n");
-    printf("SUBCOMMAND is mandatory and must take one of the following values:\n");
-    printf("  bounding-box: returns a bounding box of the loaded scene\n");
-    printf("  describe: describes the loaded scene in details\n");
-    printf("  help: shows this message\n");
-    printf("  summarize: summarizes the loaded scene\n\n");
-    printf("A scene is a text stream that must satisfy the following syntax:\n\n");
-    printf("  1. The first line must be exactly 'begin scene'\n");
-    printf("  2. The last line must be exactly 'end scene'\n");
-    printf("  3. Any line between the first and last line must either be a building line\n");
-    printf("     or an antenna line\n");
-    printf("  4. A building line has the form 'building ID X Y W H' (with any number of\n");
-    printf("     blank characters before or after), where\n");
-    printf("       ID is the building identifier\n");
-    printf("       X is the x-coordinate of the building\n");
-    printf("       Y is the y-coordinate of the building\n");
-    printf("       W is the half-width of the building\n");
-    printf("       H is the half-height of the building\n");
-    printf("  5. An antenna line has the form 'antenna ID X Y R' (with any number of\n");
-    printf("     blank characters before or after), where\n");
-    printf("       ID is the building identifier\n");
-    printf("       X is the x-coordinate of the antenna\n");
-    printf("       Y is the y-coordinate of the antenna\n");
-    printf("       R is the radius scope of the antenna\n");
+HeapEntry heap_pop(HeapEntry* heap, int* size) {
+    HeapEntry top = heap[0];
+    HeapEntry last = heap[--(*size)];
+    int pos = 0;
+    while (true) {
+        int child = 2 * pos + 1;
+        if (child >= *size) break;
+        if (child + 1 < *size &&
+            (heap[child + 1].priority > heap[child].priority ||
+             (heap[child + 1].priority == heap[child].priority &&
+              heap[child + 1].item < heap[child].item))) child++;
+        if (last.priority > heap[child].priority ||
+            (last.priority == heap[child].priority && last.item < heap[child].item)) break;
+        heap[pos] = heap[child];
+        pos = child;
+    }
+    heap[pos] = last;
+    return top;
 }
 
-// --------------------------------------------------------
-// SECTION: SCENE AND BUILDING VALIDATION FUNCTIONS
-// --------------------------------------------------------
-
-bool buildings_overlap(const Building* b1, const Building* b2) {
-    return !(b1->x + b1->w <= b2->x - b2->w || 
-             b1->x - b1->w >= b2->x + b2->w ||
-             b1->y + b1->h <= b2->y - b2->h || 
-             b1->y - b1->h >= b2->y + b2->h);
+bool pareto_search_init(const CoverSearch* search, ParetoSearch* pareto) {
+    int n = search->num_buildings, c = search->num_candidates;
+    memset(pareto, 0, sizeof(ParetoSearch));
+    pareto->gains = kover_malloc((c + 1) * sizeof(int), MEM_SOLVER);
+    pareto->coverage = kover_malloc((n + 1) * sizeof(int), MEM_SOLVER);
+    pareto->selected = kover_malloc((c + 1) * sizeof(bool), MEM_SOLVER);
+    pareto->heap = kover_malloc((c + 1) * sizeof(HeapEntry), MEM_SOLVER);
+    if (!pareto->gains || !pareto->coverage || !pareto->selected || !pareto->heap) {
+        pareto_search_free(search, pareto);
+        return false;
+    }
+    return true;
 }
 
-bool is_duplicate_building_id(const Scene* scene, const char* id) {
-    for (int i = 0; i < scene->num_buildings; i++) {
-        if (strcmp(scene->buildings[i].id, id) == 0) return true;
+void pareto_search_free(const CoverSearch* search, ParetoSearch* pareto) {
+    int n = search->num_buildings, c = search->num_candidates;
+    for (int k = 0; k < pareto->num_solutions; k++) {
+        kover_free(pareto->solutions[k].members,
+                   (pareto->solutions[k].size + 1) * sizeof(int), MEM_SOLVER);
     }
-    return false;
+    kover_free(pareto->solutions, pareto->solutions_capacity * sizeof(ParetoSolution),
+               MEM_SOLVER);
+    kover_free(pareto->gains, (c + 1) * sizeof(int), MEM_SOLVER);
+    kover_free(pareto->coverage, (n + 1) * sizeof(int), MEM_SOLVER);
+    kover_free(pareto->selected, (c + 1) * sizeof(bool), MEM_SOLVER);
+    kover_free(pareto->heap, (c + 1) * sizeof(HeapEntry), MEM_SOLVER);
+    memset(pareto, 0, sizeof(ParetoSearch));
 }
 
-bool is_duplicate_antenna_id(const Scene* scene, const char* id) {
-    for (int i = 0; i < scene->num_antennas; i++) {
-        if (strcmp(scene->antennas[i].id, id) == 0) return true;
+void pareto_select(const CoverSearch* search, ParetoSearch* pareto, int candidate) {
+    pareto->selected[candidate] = true;
+    for (int l = search->set_offsets[candidate]; l < search->set_offsets[candidate + 1]; l++) {
+        int b = search->set_buildings[l];
+        if (pareto->coverage[b]++ > 0) continue;
+        pareto->uncovered--;
+        for (int k = search->building_offsets[b]; k < search->building_offsets[b + 1]; k++) {
+            pareto->gains[search->building_candidates[k]]--;
+        }
     }
-    return false;
 }
 
-bool check_building_overlaps(const Scene* scene, char* id1, char* id2) {
-    for (int i = 0; i < scene->num_buildings; i++) {
-        for (int j = i + 1; j < scene->num_buildings; j++) {
-            if (buildings_overlap(&scene->buildings[i], &scene->buildings[j])) {
-                strcpy(id1, scene->buildings[i].id);
-                strcpy(id2, scene->buildings[j].id);
-                return true;
-            }
+void pareto_deselect(const CoverSearch* search, ParetoSearch* pareto, int candidate) {
+    pareto->selected[candidate] = false;
+    for (int l = search->set_offsets[candidate]; l < search->set_offsets[candidate + 1]; l++) {
+        int b = search->set_buildings[l];
+        if (--pareto->coverage[b] > 0) continue;
+        pareto->uncovered++;
+        for (int k = search->building_offsets[b]; k < search->building_offsets[b + 1]; k++) {
+            pareto->gains[search->building_candidates[k]]++;
         }
     }
-    return false;
 }
 
-bool has_same_position(const Antenna* a1, const Antenna* a2) {
-    return (a1->x == a2->x && a1->y == a2->y);
+bool pareto_is_redundant(const CoverSearch* search, const ParetoSearch* pareto,
+                         int candidate) {
+    for (int l = search->set_offsets[candidate]; l < search->set_offsets[candidate + 1]; l++) {
+        if (pareto->coverage[search->set_buildings[l]] < 2) return false;
+    }
+    return true;
 }
 
-bool check_antenna_positions(const Scene* scene, char* id1, char* id2) {
-    for (int i = 0; i < scene->num_antennas; i++) {
-        for (int j = i + 1; j < scene->num_antennas; j++) {
-            if (has_same_position(&scene->antennas[i], &scene->antennas[j])) {
-                strcpy(id1, scene->antennas[i].id);
-                strcpy(id2, scene->antennas[j].id);
-                return true;
-            }
+void pareto_greedy(const Scene* scene, const CoverSearch* search, ParetoSearch* pareto,
+                   double lambda) {
+    memset(pareto->coverage, 0, search->num_buildings * sizeof(int));
+    memset(pareto->selected, 0, search->num_candidates * sizeof(bool));
+    pareto->uncovered = search->num_buildings;
+    pareto->heap_size = 0;
+    for (int c = 0; c < search->num_candidates; c++) {
+        pareto->gains[c] = search->set_offsets[c + 1] - search->set_offsets[c];
+        double cost = lambda + scene->antennas[search->candidates[c]].r;
+        heap_push(pareto->heap, &pareto->heap_size, pareto->gains[c] / cost, c);
+    }
+
+    while (pareto->uncovered > 0 && pareto->heap_size > 0) {
+        HeapEntry top = heap_pop(pareto->heap, &pareto->heap_size);
+        int c = top.item;
+        if (pareto->gains[c] == 0) continue;
+        double priority = pareto->gains[c] / (lambda + scene->antennas[search->candidates[c]].r);
+        if (pareto->heap_size > 0 && priority < pareto->heap[0].priority) {
+            heap_push(pareto->heap, &pareto->heap_size, priority, c);
+            continue;
         }
+        pareto_select(search, pareto, c);
     }
-    return false;
-}
 
-// --------------------------------------------------------
-// SECTION: PARSING FUNCTIONS
-// --------------------------------------------------------
+    // Redundant antennas are removed largest radius first
+    pareto->heap_size = 0;
+    for (int c = 0; c < search->num_candidates; c++) {
+        if (!pareto->selected[c]) continue;
+        heap_push(pareto->heap, &pareto->heap_size,
+                  scene->antennas[search->candidates[c]].r, c);
+    }
+    while (pareto->heap_size > 0) {
+        int c = heap_pop(pareto->heap, &pareto->heap_size).item;
+        if (pareto_is_redundant(search, pareto, c)) pareto_deselect(search, pareto, c);
+    }
+}
 
+void* pareto_worker(void* arg) {
+    ParetoWorker* worker = arg;
+    pareto_greedy(worker->scene, worker->search, worker->pareto, worker->lambda);
+    return NULL;
+}
 
-bool validate_building_args(const char* id, const char* x_str, const char* y_str,
-                          const char* w_str, const char* h_str, int line_num) {
-    if (!is_valid_id(id)) {
-        fprintf(stderr, "error: invalid identifier \"%s\" (line #%d)\n", id, line_num);
-        return false;
-    }
-    if (!is_valid_integer(x_str)) {
-        fprintf(stderr, "error: invalid integer \"%s\" (line #%d)\n", x_str, line_num);
-        return false;
+bool pareto_archive(const Scene* scene, const CoverSearch* search, ParetoSearch* pareto,
+                    const bool* selected) {
+    int size = 0;
+    long long radii = 0;
+    for (int c = 0; c < search->num_candidates; c++) {
+        if (!selected[c]) continue;
+        size++;
+        radii += scene->antennas[search->candidates[c]].r;
     }
-    if (!is_valid_integer(y_str)) {
-        fprintf(stderr, "error: invalid integer \"%s\" (line #%d)\n", y_str, line_num);
-        return false;
+
+    int kept = 0;
+    for (int k = 0; k < pareto->num_solutions; k++) {
+        ParetoSolution* solution = &pareto->solutions[k];
+        if (solution->size <= size && solution->radii <= radii) return true;
+        if (size <= solution->size && radii <= solution->radii) {
+            kover_free(solution->members, (solution->size + 1) * sizeof(int), MEM_SOLVER);
+            continue;
+        }
+        pareto->solutions[kept++] = *solution;
     }
-    if (!is_valid_positive_integer(w_str)) {
-        fprintf(stderr, "error: invalid positive integer \"%s\" (line #%d)\n", w_str, line_num);
-        return false;
+    pareto->num_solutions = kept;
+
+    if (pareto->num_solutions == pareto->solutions_capacity) {
+        int new_capacity = pareto->solutions_capacity ? pareto->solutions_capacity * 2 : 8;
+        ParetoSolution* new_solutions = kover_realloc(
+            pareto->solutions, pareto->solutions_capacity * sizeof(ParetoSolution),
+            new_capacity * sizeof(ParetoSolution), MEM_SOLVER);
+        if (!new_solutions) return false;
+        pareto->solutions = new_solutions;
+        pareto->solutions_capacity = new_capacity;
     }
-    if (!is_valid_positive_integer(h_str)) {
-        fprintf(stderr, "error: invalid positive integer \"%s\" (line #%d)\n", h_str, line_num);
-        return false;
+    int* members = kover_malloc((size + 1) * sizeof(int), MEM_SOLVER);
+    if (!members) return false;
+    ParetoSolution* solution = &pareto->solutions[pareto->num_solutions++];
+    solution->size = 0;
+    solution->radii = radii;
+    solution->members = members;
+    for (int c = 0; c < search->num_candidates; c++) {
+        if (selected[c]) members[solution->size++] = c;
     }
     return true;
 }
 
-bool extract_building_args(const char* line, char* id, char* x_str, char* y_str,
-                         char* w_str, char* h_str, int line_num) {
-    if (sscanf(line, " building %10s %10s %10s %10s %10s ",
-               id, x_str, y_str, w_str, h_str) != 5) {
-        fprintf(stderr, "error: building line has wrong number of arguments (line #%d)\n", line_num);
-        return false;
+void print_bounding_box(const Scene* scene, FILE* output) {
+    if (scene->num_buildings == 0 && scene->num_antennas == 0) {
+        fprintf(output, "undefined (empty scene)\n");
+        return;
     }
-    return true;
-}
-
-void construct_building(Building* building, const char* id, const char* x_str,
-                      const char* y_str, const char* w_str, const char* h_str) {
-    strcpy(building->id, id);
-    building->x = atoi(x_str);
-    building->y = atoi(y_str);
-    building->w = atoi(w_str);
-    building->h = atoi(h_str);
+    int min_x, max_x, min_y, max_y;
+    compute_bounding_box(scene, &min_x, &max_x, &min_y, &max_y);
+    fprintf(output, "bounding box [%d, %d] x [%d, %d]\n", min_x, max_x, min_y, max_y);
 }
 
-bool parse_building_line(const char* line, Building* building, int line_num) {
-    char id[MAX_ID_LENGTH];
-    char x_str[MAX_ARG_LENGTH], y_str[MAX_ARG_LENGTH];
-    char w_str[MAX_ARG_LENGTH], h_str[MAX_ARG_LENGTH];
-    
-    if (!extract_building_args(line, id, x_str, y_str, w_str, h_str, line_num)) {
-        return false;
+void print_summary(const Scene* scene, FILE* output) {
+    if (scene->num_buildings == 0 && scene->num_antennas == 0) {
+        fprintf(output, "An empty scene\n");
+        return;
     }
+    fprintf(output, "A scene with ");
     
-    if (!validate_building_args(id, x_str, y_str, w_str, h_str, line_num)) {
-        return false;
+    if (scene->num_buildings > 0) {
+        fprintf(output, "%d building%s", scene->num_buildings, scene->num_buildings > 1 ? "s" : "");
+        if (scene->num_antennas > 0) fprintf(output, " and ");
     }
     
-    construct_building(building, id, x_str, y_str, w_str, h_str);
-    return true;
+    if (scene->num_antennas > 0) {
+        fprintf(output, "%d antenna%s", scene->num_antennas, scene->num_antennas > 1 ? "s" : "");
+    }
+    fprintf(output, "\n");
 }
 
-bool validate_antenna_args(const char* id, const char* x_str, const char* y_str,
-                         const char* r_str, int line_num) {
-    if (!is_valid_id(id)) {
-        fprintf(stderr, "error: invalid identifier \"%s\" (line #%d)\n", id, line_num);
+void print_building(const Building* b, FILE* output) {
+    fprintf(output, "  building %s at %d %d with dimensions %d %d\n", 
+           b->id, b->x, b->y, b->w, b->h);
+}
+
+void print_antenna(const Antenna* a, FILE* output) {
+    if (is_omnidirectional(a)) {
+        fprintf(output, "  antenna %s at %d %d with range %d\n", 
+               a->id, a->x, a->y, a->r);
+        return;
+    }
+    fprintf(output, "  antenna %s at %d %d with range %d, azimuth %d and beamwidth %d\n",
+           a->id, a->x, a->y, a->r, a->azimuth, a->beamwidth);
+}
+
+int compare_ids(const void* a, const void* b) {
+    return strcmp(*(const char**)a, *(const char**)b);
+}
+
+int compare_buildings(const void* a, const void* b) {
+    return strcmp((*(const Building**)a)->id, (*(const Building**)b)->id);
+}
+
+int compare_antennas(const void* a, const void* b) {
+    return strcmp((*(const Antenna**)a)->id, (*(const Antenna**)b)->id);
+}
+
+int compare_solutions(const void* a, const void* b) {
+    return ((const ParetoSolution*)a)->size - ((const ParetoSolution*)b)->size;
+}
+
+bool print_description(const Scene* scene, FILE* output) {
+    print_summary(scene, output);
+#ifdef KOVER_REFERENCE
+    return reference_print_sorted_buildings(scene, output) &&
+           reference_print_sorted_antennas(scene, output);
+#else
+    return print_sorted_buildings(scene, output) && print_sorted_antennas(scene, output);
+#endif
+}
+
+bool print_minimum_cover(const Scene* scene, FILE* output) {
+    CoverSearch search;
+    int uncoverable;
+    if (!cover_search_init(scene, &search, false, true, &uncoverable)) {
+        print_error_memory();
         return false;
     }
-    if (!is_valid_integer(x_str)) {
-        fprintf(stderr, "error: invalid integer \"%s\" (line #%d)\n", x_str, line_num);
+    if (uncoverable >= 0) {
+        fprintf(output, "no cover (building %s is not covered by any antenna)\n",
+                scene->buildings[uncoverable].id);
+        cover_search_free(&search);
+        return true;
+    }
+
+    // Scenes too large for the bitsets only get the greedy cover of the
+    // trade-off exploration, with an antenna costing more than any gain
+    trace_event("cover_search", 'B');
+    if (search.sets) {
+        search.nodes_left = subcommand_args.max_nodes ? subcommand_args.max_nodes :
+            COVER_SEARCH_WORK / ((long long)search.num_candidates * search.words + 1) + 1;
+        cover_greedy(&search);
+        cover_branch(&search, 0);
+    } else {
+        ParetoSearch pareto;
+        if (!pareto_search_init(&search, &pareto)) {
+            print_error_memory();
+            cover_search_free(&search);
+            return false;
+        }
+        double max_radius = 0;
+        for (int c = 0; c < search.num_candidates; c++) {
+            max_radius = fmax(max_radius, scene->antennas[search.candidates[c]].r);
+        }
+        pareto_greedy(scene, &search, &pareto, max_radius * (search.num_buildings + 1) + 1);
+        for (int c = 0; c < search.num_candidates; c++) {
+            if (pareto.selected[c]) search.best[search.best_size++] = c;
+        }
+        pareto_search_free(&search, &pareto);
+        search.stopped = true;
+    }
+    trace_event("cover_search", 'E');
+
+    const Antenna** cover = kover_malloc((search.best_size + 1) * sizeof(Antenna*), MEM_OUTPUT);
+    if (!cover) {
+        print_error_memory();
+        cover_search_free(&search);
         return false;
     }
-    if (!is_valid_integer(y_str)) {
-        fprintf(stderr, "error: invalid integer \"%s\" (line #%d)\n", y_str, line_num);
-        return false;
+    for (int k = 0; k < search.best_size; k++) {
+        cover[k] = &scene->antennas[search.candidates[search.best[k]]];
     }
-    if (!is_valid_positive_integer(r_str)) {
-        fprintf(stderr, "error: invalid positive integer \"%s\" (line #%d)\n", r_str, line_num);
-        return false;
+    qsort(cover, search.best_size, sizeof(Antenna*), compare_antennas);
+    if (search.stopped) {
+        fprintf(output, "cover with %d antenna%s (not proven minimum)\n", search.best_size,
+                search.best_size == 1 ? "" : "s");
+    } else {
+        fprintf(output, "minimum cover with %d antenna%s\n", search.best_size,
+                search.best_size == 1 ? "" : "s");
     }
+    for (int k = 0; k < search.best_size; k++) print_antenna(cover[k], output);
+    kover_free(cover, (search.best_size + 1) * sizeof(Antenna*), MEM_OUTPUT);
+    cover_search_free(&search);
     return true;
 }
 
-bool extract_antenna_args(const char* line, char* id, char* x_str, char* y_str,
-                        char* r_str, int line_num) {
-    if (sscanf(line, " antenna %10s %10s %10s %10s ",
-               id, x_str, y_str, r_str) != 4) {
-        fprintf(stderr, "error: antenna line has wrong number of arguments (line #%d)\n", line_num);
-        return false;
+void count_building_coverage(const Scene* scene, int* counts, int* found) {
+    memset(counts, 0, scene->num_buildings * sizeof(int));
+    for (unsigned int i = 0; i < scene->num_antennas; i++) {
+        const Antenna* a = &scene->antennas[i];
+        int count = find_buildings_in_box(scene, a->min_x, a->max_x, a->min_y, a->max_y, found);
+        for (int k = 0; k < count; k++) {
+            if (antenna_covers_building(a, &scene->buildings[found[k]])) counts[found[k]]++;
+        }
     }
-    return true;
-}
-
-void construct_antenna(Antenna* antenna, const char* id, const char* x_str,
-                      const char* y_str, const char* r_str) {
-    strcpy(antenna->id, id);
-    antenna->x = atoi(x_str);
-    antenna->y = atoi(y_str);
-    antenna->r = atoi(r_str);
 }
 
-bool parse_antenna_line(const char* line, Antenna* antenna, int line_num) {
-    char id[MAX_ID_LENGTH];
-    char x_str[MAX_ARG_LENGTH], y_str[MAX_ARG_LENGTH], r_str[MAX_ARG_LENGTH];
-    
-    if (!extract_antenna_args(line, id, x_str, y_str, r_str, line_num)) {
-        return false;
-    }
-    
-    if (!validate_antenna_args(id, x_str, y_str, r_str, line_num)) {
+bool print_coverage_report(const Scene* scene, FILE* output) {
+    unsigned int n = scene->num_buildings;
+    int min_coverage = subcommand_args.min_coverage;
+    int* counts = kover_malloc((n + 1) * sizeof(int), MEM_OUTPUT);
+    int* found = kover_malloc((n + 1) * sizeof(int), MEM_OUTPUT);
+    const Building** below = kover_malloc((n + 1) * sizeof(Building*), MEM_OUTPUT);
+    if (!counts || !found || !below) {
+        print_error_memory();
+        kover_free(counts, (n + 1) * sizeof(int), MEM_OUTPUT);
+        kover_free(found, (n + 1) * sizeof(int), MEM_OUTPUT);
+        kover_free(below, (n + 1) * sizeof(Building*), MEM_OUTPUT);
         return false;
     }
-    
-    construct_antenna(antenna, id, x_str, y_str, r_str);
-    return true;
-}
 
-void print_sorted_buildings(const Scene* scene) {
-    const char* building_ids[MAX_BUILDINGS];
-    for (int i = 0; i < scene->num_buildings; i++) {
-        building_ids[i] = scene->buildings[i].id;
+    trace_event("coverage_join", 'B');
+    count_building_coverage(scene, counts, found);
+    trace_event("coverage_join", 'E');
+
+    int num_below = 0, max_count = 0;
+    for (unsigned int i = 0; i < n; i++) {
+        if (counts[i] < min_coverage) below[num_below++] = &scene->buildings[i];
+        if (counts[i] > max_count) max_count = counts[i];
     }
-    qsort(building_ids, scene->num_buildings, sizeof(char*), compare_ids);
-    
-    for (int i = 0; i < scene->num_buildings; i++) {
-        for (int j = 0; j < scene->num_buildings; j++) {
-            if (strcmp(building_ids[i], scene->buildings[j].id) == 0) {
-                print_building(&scene->buildings[j]);
-                break;
-            }
+    qsort(below, num_below, sizeof(Building*), compare_buildings);
+
+    // Allocated before printing, so that a failed report prints nothing
+    int* histogram = kover_malloc((max_count + 1) * sizeof(int), MEM_OUTPUT);
+    if (!histogram) {
+        print_error_memory();
+    } else {
+        memset(histogram, 0, (max_count + 1) * sizeof(int));
+        for (unsigned int i = 0; i < n; i++) histogram[counts[i]]++;
+
+        fprintf(output, "%d building%s covered by fewer than %d antenna%s\n", num_below,
+                num_below == 1 ? "" : "s", min_coverage, min_coverage == 1 ? "" : "s");
+        for (int k = 0; k < num_below; k++) {
+            int count = counts[below[k] - scene->buildings];
+            fprintf(output, "  building %s covered by %d antenna%s\n", below[k]->id, count,
+                    count == 1 ? "" : "s");
+        }
+
+        fprintf(output, "coverage histogram\n");
+        for (int count = 0; n > 0 && count <= max_count; count++) {
+            fprintf(output, "  %d antenna%s: %d building%s\n", count, count == 1 ? "" : "s",
+                    histogram[count], histogram[count] == 1 ? "" : "s");
         }
     }
+
+    kover_free(counts, (n + 1) * sizeof(int), MEM_OUTPUT);
+    kover_free(found, (n + 1) * sizeof(int), MEM_OUTPUT);
+    kover_free(below, (n + 1) * sizeof(Building*), MEM_OUTPUT);
+    kover_free(histogram, (max_count + 1) * sizeof(int), MEM_OUTPUT);
+    return histogram != NULL;
 }
 
-void print_sorted_antennas(const Scene* scene) {
-    const char* antenna_ids[MAX_ANTENNAS];
-    for (int i = 0; i < scene->num_antennas; i++) {
-        antenna_ids[i] = scene->antennas[i].id;
-    }
-    qsort(antenna_ids, scene->num_antennas, sizeof(char*), compare_ids);
-    
-    for (int i = 0; i < scene->num_antennas; i++) {
-        for (int j = 0; j < scene->num_antennas; j++) {
-            if (strcmp(antenna_ids[i], scene->antennas[j].id) == 0) {
-                print_antenna(&scene->antennas[j]);
-                break;
-            }
+int compare_points(const void* a, const void* b) {
+    return strcmp(((const NeighbourPoint*)a)->id, ((const NeighbourPoint*)b)->id);
+}
+
+void print_neighbours(const NeighbourPoint* points, int n, const char* kind, FILE* output) {
+    int histogram[DISTANCE_BUCKETS] = {0};
+    int last = -1;
+    fprintf(output, "nearest %s of each %s\n", kind, kind);
+    for (int i = 0; i < n; i++) {
+        const NeighbourPoint* p = &points[i];
+        if (p->nearest < 0) {
+            fprintf(output, "  %s %s: none\n", kind, p->id);
+            continue;
         }
+        fprintf(output, "  %s %s: %s at distance %.2f\n", kind, p->id,
+                points[p->nearest].id, p->distance);
+        int bucket = 0;
+        while ((double)(1LL << bucket) <= p->distance) bucket++;
+        histogram[bucket]++;
+        if (bucket > last) last = bucket;
+    }
+
+    fprintf(output, "%s distances histogram\n", kind);
+    for (int bucket = 0; bucket <= last; bucket++) {
+        fprintf(output, "  [%lld, %lld): %d %s%s\n", bucket ? 1LL << (bucket - 1) : 0LL,
+                1LL << bucket, histogram[bucket], kind, histogram[bucket] == 1 ? "" : "s");
     }
 }
 
-// --------------------------------------------------------
-// SECTION: SCENE PROCESSING FUNCTIONS
-// --------------------------------------------------------
+bool print_nearest_neighbours(const Scene* scene, FILE* output) {
+    unsigned int nb = scene->num_buildings, na = scene->num_antennas;
+    NeighbourPoint* buildings = kover_malloc((nb + 1) * sizeof(NeighbourPoint), MEM_OUTPUT);
+    NeighbourPoint* antennas = kover_malloc((na + 1) * sizeof(NeighbourPoint), MEM_OUTPUT);
+    if (buildings && antennas) {
+        for (unsigned int i = 0; i < nb; i++) {
+            const Building* b = &scene->buildings[i];
+            buildings[i] = (NeighbourPoint){b->id, b->x, b->y, -1, 0};
+        }
+        for (unsigned int i = 0; i < na; i++) {
+            const Antenna* a = &scene->antennas[i];
+            antennas[i] = (NeighbourPoint){a->id, a->x, a->y, -1, 0};
+        }
+        // Sorted first, so that ties go to the lowest identifier
+        qsort(buildings, nb, sizeof(NeighbourPoint), compare_points);
+        qsort(antennas, na, sizeof(NeighbourPoint), compare_points);
+    }
 
-void init_scene(Scene* scene) {
-    scene->num_buildings = 0;
-    scene->num_antennas = 0;
+    trace_event("nearest_neighbours", 'B');
+    bool found = buildings && antennas && find_nearest_neighbours(buildings, nb) &&
+                 find_nearest_neighbours(antennas, na);
+    trace_event("nearest_neighbours", 'E');
+
+    if (found) {
+        print_neighbours(buildings, nb, "building", output);
+        print_neighbours(antennas, na, "antenna", output);
+    } else {
+        print_error_memory();
+    }
+    kover_free(buildings, (nb + 1) * sizeof(NeighbourPoint), MEM_OUTPUT);
+    kover_free(antennas, (na + 1) * sizeof(NeighbourPoint), MEM_OUTPUT);
+    return found;
 }
 
-bool process_building(Scene* scene, const char* line, int line_num) {
-    Building building;
-    if (!parse_building_line(line, &building, line_num)) return false;
-    
-    if (is_duplicate_building_id(scene, building.id)) {
-        fprintf(stderr, "error: building identifier %s is non unique\n", building.id);
+bool print_rooftops(const Scene* scene, FILE* output) {
+    unsigned int n = scene->num_antennas;
+    const Antenna** sorted = kover_malloc((n + 1) * sizeof(Antenna*), MEM_OUTPUT);
+    int* buildings = kover_malloc((n + 1) * sizeof(int), MEM_OUTPUT);
+    if (!sorted || !buildings) {
+        print_error_memory();
+        kover_free(sorted, (n + 1) * sizeof(Antenna*), MEM_OUTPUT);
+        kover_free(buildings, (n + 1) * sizeof(int), MEM_OUTPUT);
         return false;
     }
-    
-    for (int i = 0; i < scene->num_buildings; i++) {
-        if (buildings_overlap(&scene->buildings[i], &building)) {
-            fprintf(stderr, "error: buildings %s and %s are overlapping\n", scene->buildings[i].id, building.id);
-            return false;
+    for (unsigned int i = 0; i < n; i++) sorted[i] = &scene->antennas[i];
+    qsort(sorted, n, sizeof(Antenna*), compare_antennas);
+
+    trace_event("rooftops", 'B');
+    int on_rooftops = 0;
+    for (unsigned int i = 0; i < n; i++) {
+        buildings[i] = find_building_at(scene, sorted[i]->x, sorted[i]->y);
+        if (buildings[i] >= 0) on_rooftops++;
+    }
+    trace_event("rooftops", 'E');
+
+    fprintf(output, "%d antenna%s on rooftops, %d ground-mounted\n", on_rooftops,
+            on_rooftops == 1 ? "" : "s", n - on_rooftops);
+    for (unsigned int i = 0; i < n; i++) {
+        if (buildings[i] < 0) {
+            fprintf(output, "  antenna %s ground-mounted\n", sorted[i]->id);
+        } else {
+            fprintf(output, "  antenna %s on building %s\n", sorted[i]->id,
+                    scene->buildings[buildings[i]].id);
         }
     }
-    
-    scene->buildings[scene->num_buildings++] = building;
+    kover_free(sorted, (n + 1) * sizeof(Antenna*), MEM_OUTPUT);
+    kover_free(buildings, (n + 1) * sizeof(int), MEM_OUTPUT);
     return true;
 }
 
-bool process_antenna(Scene* scene, const char* line, int line_num) {
-    Antenna antenna;
-    if (!parse_antenna_line(line, &antenna, line_num)) return false;
-    
-    if (is_duplicate_antenna_id(scene, antenna.id)) {
-        fprintf(stderr, "error: antenna identifier %s is non unique\n", antenna.id);
-        return false;
+void print_hull_point(const HullPoint* p, FILE* output) {
+    double x = fabs(p->x) < 0.005 ? 0 : p->x, y = fabs(p->y) < 0.005 ? 0 : p->y;
+    fprintf(output, "%.2f %.2f", x, y);
+}
+
+bool print_hull(const Scene* scene, FILE* output) {
+    if (scene->num_buildings == 0 && scene->num_antennas == 0) {
+        fprintf(output, "undefined (empty scene)\n");
+        return true;
     }
-    
-    scene->antennas[scene->num_antennas++] = antenna;
-    
-    char id1[MAX_ID_LENGTH], id2[MAX_ID_LENGTH];
-    if (check_antenna_positions(scene, id1, id2)) {
-        fprintf(stderr, "error: antennas %s and %s have the same position\n", id1, id2);
+    int sides = subcommand_args.disk_sides;
+    size_t n = 4 * (size_t)scene->num_buildings + (size_t)(sides + 3) * scene->num_antennas;
+    HullPoint* points = kover_malloc(n * sizeof(HullPoint), MEM_OUTPUT);
+    HullPoint* hull = kover_malloc((n + 1) * sizeof(HullPoint), MEM_OUTPUT);
+    if (!points || !hull) {
+        print_error_memory();
+        kover_free(points, n * sizeof(HullPoint), MEM_OUTPUT);
+        kover_free(hull, (n + 1) * sizeof(HullPoint), MEM_OUTPUT);
         return false;
     }
+
+    trace_event("hull", 'B');
+    int h = convex_hull(points, collect_hull_points(scene, sides, points), hull);
+    HullPoint corners[4], center;
+    double box_area = minimum_area_rectangle(hull, h, corners);
+    // The hull vertices are the only points that can bound the circle
+    memcpy(points, hull, h * sizeof(HullPoint));
+    double radius = minimum_enclosing_circle(points, h, &center);
+    trace_event("hull", 'E');
+
+    double area = 0;
+    for (int i = 0; i < h; i++) area += cross_product(&hull[0], &hull[i], &hull[(i + 1) % h]);
+    fprintf(output, "convex hull with %d vertices and area %.2f\n", h, area / 2);
+    for (int i = 0; i < h; i++) {
+        fprintf(output, "  vertex ");
+        print_hull_point(&hull[i], output);
+        fprintf(output, "\n");
+    }
+    double angle = atan2(corners[1].y - corners[0].y, corners[1].x - corners[0].x) * 180 / M_PI;
+    if (angle < 0) angle += 180;
+    if (angle >= 180 - 0.005) angle = 0;
+    fprintf(output, "oriented bounding box with area %.2f and angle %.2f\n", box_area, angle);
+    for (int i = 0; i < 4; i++) {
+        fprintf(output, "  corner ");
+        print_hull_point(&corners[i], output);
+        fprintf(output, "\n");
+    }
+    fprintf(output, "minimum enclosing circle with center ");
+    print_hull_point(&center, output);
+    fprintf(output, " and radius %.2f\n", radius);
+
+    kover_free(points, n * sizeof(HullPoint), MEM_OUTPUT);
+    kover_free(hull, (n + 1) * sizeof(HullPoint), MEM_OUTPUT);
     return true;
 }
 
-bool process_line(Scene* scene, char* line, int line_num) {
-    char type[MAX_ARG_LENGTH];
-    if (sscanf(line, " %10s ", type) != 1) {
-        print_error_line(line_num);
+void print_solution_scene(const Scene* scene, const CoverSearch* search,
+                          const ParetoSolution* solution, FILE* output) {
+    fprintf(output, "begin scene\n");
+    for (unsigned int i = 0; i < scene->num_buildings; i++) {
+        const Building* b = &scene->buildings[i];
+        fprintf(output, "  building %s %d %d %d %d\n", b->id, b->x, b->y, b->w, b->h);
+    }
+    for (int k = 0; k < solution->size; k++) {
+        const Antenna* a = &scene->antennas[search->candidates[solution->members[k]]];
+        fprintf(output, "  antenna %s %d %d %d", a->id, a->x, a->y, a->r);
+        if (!is_omnidirectional(a)) fprintf(output, " %d %d", a->azimuth, a->beamwidth);
+        fprintf(output, "\n");
+    }
+    fprintf(output, "end scene\n");
+}
+
+bool print_pareto_frontier(const Scene* scene, FILE* output) {
+    CoverSearch search;
+    ParetoSearch pareto[PARETO_MAX_THREADS];
+    int uncoverable;
+    if (!cover_search_init(scene, &search, true, false, &uncoverable)) {
+        print_error_memory();
         return false;
     }
+    if (uncoverable >= 0) {
+        fprintf(output, "no cover (building %s is not covered by any antenna)\n",
+                scene->buildings[uncoverable].id);
+        cover_search_free(&search);
+        return true;
+    }
 
-    if (strcmp(type, "building") == 0) 
-        return process_building(scene, line, line_num);
-    else if (strcmp(type, "antenna") == 0) 
-        return process_antenna(scene, line, line_num);
-    
-    print_error_line(line_num);
-    return false;
-}
+    // From the smallest radii (lambda 0) to the fewest antennas (lambda above
+    // any radius times any gain, where the gain alone decides)
+    double max_radius = 0;
+    for (int c = 0; c < search.num_candidates; c++) {
+        max_radius = fmax(max_radius, scene->antennas[search.candidates[c]].r);
+    }
+    double max_lambda = max_radius * (search.num_buildings + 1);
+    int num_lambdas = 1;
+    for (double lambda = 0; lambda <= max_lambda; lambda = lambda > 0 ? lambda * 2 : 1) {
+        num_lambdas++;
+    }
 
-bool read_scene(Scene* scene) {
-    char line[MAX_LINE_LENGTH];
-    
-    if (!fgets(line, MAX_LINE_LENGTH, stdin)) return false;
-    line[strcspn(line, "\n")] = 0;
-    if (!is_begin_scene(line)) {
-        fprintf(stderr, "error: first line must be exactly 'begin scene'\n");
+    // One state per worker, the solutions being archived in the first one
+    int threads = subcommand_args.threads;
+    if (threads == 0) threads = (int)fmin(sysconf(_SC_NPROCESSORS_ONLN), PARETO_MAX_THREADS);
+    if (threads > num_lambdas) threads = num_lambdas;
+    if (threads < 1) threads = 1;
+    for (int k = 0; k < threads; k++) {
+        if (pareto_search_init(&search, &pareto[k])) continue;
+        print_error_memory();
+        for (int l = 0; l < k; l++) pareto_search_free(&search, &pareto[l]);
+        cover_search_free(&search);
         return false;
     }
-    
-    int line_num = 1;
-    
-    while (fgets(line, MAX_LINE_LENGTH, stdin)) {
-        line_num++;
-        line[strcspn(line, "\n")] = 0;
-        
-        if (is_end_scene(line)) return true;
-        if (!process_line(scene, line, line_num)) return false;
+
+    // Batches of consecutive lambdas, archived by increasing lambda as in a
+    // sequential exploration; a worker whose thread cannot be started runs on
+    // the current thread
+    trace_event("pareto_search", 'B');
+    ParetoWorker workers[PARETO_MAX_THREADS];
+    pthread_t ids[PARETO_MAX_THREADS];
+    bool started[PARETO_MAX_THREADS];
+    bool archived = true;
+    double lambda = 0;
+    for (int first = 0; first < num_lambdas && archived; first += threads) {
+        int batch = num_lambdas - first < threads ? num_lambdas - first : threads;
+        for (int k = 0; k < batch; k++) {
+            workers[k] = (ParetoWorker){scene, &search, &pareto[k], lambda};
+            lambda = lambda > 0 ? lambda * 2 : 1;
+        }
+        for (int k = 1; k < batch; k++) {
+            started[k] = pthread_create(&ids[k], NULL, pareto_worker, &workers[k]) == 0;
+        }
+        pareto_worker(&workers[0]);
+        for (int k = 1; k < batch; k++) {
+            if (started[k]) {
+                pthread_join(ids[k], NULL);
+            } else {
+                pareto_worker(&workers[k]);
+            }
+        }
+        for (int k = 0; k < batch && archived; k++) {
+            archived = pareto_archive(scene, &search, &pareto[0], pareto[k].selected);
+        }
     }
-    
-    fprintf(stderr, "error: last line must be exactly 'end scene'\n");
-    return false;
+    trace_event("pareto_search", 'E');
+
+    if (!archived) {
+        print_error_memory();
+    } else {
+        qsort(pareto[0].solutions, pareto[0].num_solutions, sizeof(ParetoSolution),
+              compare_solutions);
+        for (int k = 0; k < pareto[0].num_solutions; k++) {
+            print_solution_scene(scene, &search, &pareto[0].solutions[k], output);
+        }
+    }
+    for (int k = 0; k < threads; k++) pareto_search_free(&search, &pareto[k]);
+    cover_search_free(&search);
+    return archived;
+}
+
+bool run_subcommand(const char* subcommand, const Scene* scene, FILE* output) {
+    if (strcmp(subcommand, "bounding-box") == 0) {
+        print_bounding_box(scene, output);
+    }
+    else if (strcmp(subcommand, "cover") == 0) {
+        return print_minimum_cover(scene, output);
+    }
+    else if (strcmp(subcommand, "coverage") == 0) {
+        return print_coverage_report(scene, output);
+    }
+    else if (strcmp(subcommand, "describe") == 0) {
+        return print_description(scene, output);
+    }
+    else if (strcmp(subcommand, "hull") == 0) {
+        return print_hull(scene, output);
+    }
+    else if (strcmp(subcommand, "nearest") == 0) {
+        return print_nearest_neighbours(scene, output);
+    }
+    else if (strcmp(subcommand, "optimize") == 0) {
+        return print_pareto_frontier(scene, output);
+    }
+    else if (strcmp(subcommand, "rooftops") == 0) {
+        return print_rooftops(scene, output);
+    }
+    else if (strcmp(subcommand, "summarize") == 0) {
+        print_summary(scene, output);
+    }
+    return true;
 }
 
 // --------------------------------------------------------
-// SECTION: SCENE COMPUTATION FUNCTIONS
+// SECTION: STATISTICS FUNCTIONS
 // --------------------------------------------------------
 
-void compute_bounding_box(const Scene* scene, int* min_x, int* max_x, int* min_y, int* max_y) {
-    *min_x = INT_MAX;
-    *max_x = INT_MIN;
-    *min_y = INT_MAX;
-    *max_y = INT_MIN;
+double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
 
-    for (int i = 0; i < scene->num_buildings; i++) {
-        const Building* b = &scene->buildings[i];
-        if (b->x - b->w < *min_x) *min_x = b->x - b->w;
-        if (b->x + b->w > *max_x) *max_x = b->x + b->w;
-        if (b->y - b->h < *min_y) *min_y = b->y - b->h;
-        if (b->y + b->h > *max_y) *max_y = b->y + b->h;
-    }
+void record_scene_latency(double seconds) {
+    int bucket = 0;
+    while (bucket < STATS_BUCKETS && seconds * 1e6 > (double)(1ULL << bucket)) bucket++;
+    stats.scene_latency[bucket]++;
+    stats.scene_seconds += seconds;
+    stats.scenes++;
+}
 
-    for (int i = 0; i < scene->num_antennas; i++) {
-        const Antenna* a = &scene->antennas[i];
-        if (a->x - a->r < *min_x) *min_x = a->x - a->r;
-        if (a->x + a->r > *max_x) *max_x = a->x + a->r;
-        if (a->y - a->r < *min_y) *min_y = a->y - a->r;
-        if (a->y + a->r > *max_y) *max_y = a->y + a->r;
+void merge_stats(Stats* total, const Stats* part) {
+    total->scenes += part->scenes;
+    total->lines += part->lines;
+    total->buildings += part->buildings;
+    total->antennas += part->antennas;
+    total->id_lookups += part->id_lookups;
+    total->id_probes += part->id_probes;
+    total->grid_lookups += part->grid_lookups;
+    total->grid_visits += part->grid_visits;
+    total->cover_nodes += part->cover_nodes;
+    total->cache_hits += part->cache_hits;
+    total->cache_misses += part->cache_misses;
+    total->cache_evictions += part->cache_evictions;
+    for (int bucket = 0; bucket <= STATS_BUCKETS; bucket++) {
+        total->scene_latency[bucket] += part->scene_latency[bucket];
     }
+    total->scene_seconds += part->scene_seconds;
 }
 
-// --------------------------------------------------------
-// SECTION: OUTPUT FUNCTIONS
-// --------------------------------------------------------
+void print_counter(FILE* output, const char* name, const char* help,
+                   unsigned long long value) {
+    fprintf(output, "# HELP %s %s\n", name, help);
+    fprintf(output, "# TYPE %s counter\n", name);
+    fprintf(output, "%s %llu\n", name, value);
+}
 
-void print_bounding_box(const Scene* scene) {
-    if (scene->num_buildings == 0 && scene->num_antennas == 0) {
-        printf("undefined (empty scene)\n");
-        return;
+void print_stats(FILE* output) {
+    print_counter(output, "kover_scenes_total", "Scenes loaded and processed.", stats.scenes);
+    print_counter(output, "kover_lines_total", "Lines read.", stats.lines);
+    print_counter(output, "kover_buildings_total", "Buildings loaded.", stats.buildings);
+    print_counter(output, "kover_antennas_total", "Antennas loaded.", stats.antennas);
+    print_counter(output, "kover_id_lookups_total", "Identifier index lookups.", stats.id_lookups);
+    print_counter(output, "kover_id_probes_total", "Identifier index slots visited.", stats.id_probes);
+    print_counter(output, "kover_grid_lookups_total", "Grid index queries.", stats.grid_lookups);
+    print_counter(output, "kover_grid_visits_total", "Grid index entries visited.", stats.grid_visits);
+    print_counter(output, "kover_cover_nodes_total", "Nodes explored by the cover solver.",
+                  stats.cover_nodes);
+    print_counter(output, "kover_cache_hits_total", "Watched versions served from the result cache.",
+                  stats.cache_hits);
+    print_counter(output, "kover_cache_misses_total", "Watched versions evaluated.",
+                  stats.cache_misses);
+    print_counter(output, "kover_cache_evictions_total", "Cached results evicted.",
+                  stats.cache_evictions);
+
+    fprintf(output, "# HELP kover_scene_seconds Time spent loading and processing a scene.\n");
+    fprintf(output, "# TYPE kover_scene_seconds histogram\n");
+    unsigned long long cumulated = 0;
+    for (int bucket = 0; bucket < STATS_BUCKETS; bucket++) {
+        cumulated += stats.scene_latency[bucket];
+        fprintf(output, "kover_scene_seconds_bucket{le=\"%.6f\"} %llu\n",
+                (double)(1ULL << bucket) / 1e6, cumulated);
     }
-    int min_x, max_x, min_y, max_y;
-    compute_bounding_box(scene, &min_x, &max_x, &min_y, &max_y);
-    printf("bounding box [%d, %d] x [%d, %d]\n", min_x, max_x, min_y, max_y);
+    fprintf(output, "kover_scene_seconds_bucket{le=\"+Inf\"} %llu\n", stats.scenes);
+    fprintf(output, "kover_scene_seconds_sum %.9f\n", stats.scene_seconds);
+    fprintf(output, "kover_scene_seconds_count %llu\n", stats.scenes);
+
+    fprintf(output, "# HELP kover_memory_peak_bytes Highest memory allocation per subsystem.\n");
+    fprintf(output, "# TYPE kover_memory_peak_bytes gauge\n");
+    for (int subsystem = 0; subsystem < MEM_SUBSYSTEMS; subsystem++) {
+        fprintf(output, "kover_memory_peak_bytes{subsystem=\"%s\"} %zu\n",
+                MEM_SUBSYSTEM_NAMES[subsystem], memory.peak[subsystem]);
+    }
+    fprintf(output, "kover_memory_peak_bytes{subsystem=\"total\"} %zu\n", memory.total_peak);
 }
 
-void print_summary(const Scene* scene) {
-    if (scene->num_buildings == 0 && scene->num_antennas == 0) {
-        printf("An empty scene\n");
-        return;
+int parse_options(int argc, char* argv[], Options* options) {
+    options->stats = false;
+    options->trace_path = NULL;
+    options->max_memory = 0;
+    options->cache_size = DEFAULT_CACHE_SIZE;
+    options->min_antenna_spacing = 0;
+    options->jobs = 1;
+
+    int i = 1;
+    while (i < argc && strncmp(argv[i], "--", 2) == 0) {
+        if (strcmp(argv[i], "--stats") == 0) {
+            options->stats = true;
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            if (i + 1 >= argc) {
+                print_error_option_argument(argv[i]);
+                return -1;
+            }
+            options->trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--max-memory") == 0) {
+            if (i + 1 >= argc) {
+                print_error_option_argument(argv[i]);
+                return -1;
+            }
+            if (!parse_memory_size(argv[++i], &options->max_memory)) {
+                print_error_memory_size(argv[i]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--cache-size") == 0) {
+            if (i + 1 >= argc) {
+                print_error_option_argument(argv[i]);
+                return -1;
+            }
+            if (strcmp(argv[++i], "0") == 0) {
+                options->cache_size = 0;
+            } else if (!parse_memory_size(argv[i], &options->cache_size)) {
+                print_error_memory_size(argv[i]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--min-antenna-spacing") == 0) {
+            if (i + 1 >= argc) {
+                print_error_option_argument(argv[i]);
+                return -1;
+            }
+            if (!is_valid_positive_integer(argv[++i]) || strlen(argv[i]) > 9) {
+                print_error_spacing(argv[i]);
+                return -1;
+            }
+            options->min_antenna_spacing = atoi(argv[i]);
+        } else if (strcmp(argv[i], "--jobs") == 0) {
+            if (i + 1 >= argc) {
+                print_error_option_argument(argv[i]);
+                return -1;
+            }
+            if (!is_valid_positive_integer(argv[++i]) || strlen(argv[i]) > 9 ||
+                atoi(argv[i]) < 1 || atoi(argv[i]) > MAX_JOBS) {
+                print_error_jobs(argv[i]);
+                return -1;
+            }
+            options->jobs = atoi(argv[i]);
+        } else {
+            print_error_option(argv[i]);
+            return -1;
+        }
+        i++;
     }
-    printf("A scene with ");
-    
-    if (scene->num_buildings > 0) {
-        printf("%d building%s", scene->num_buildings, scene->num_buildings > 1 ? "s" : "");
-        if (scene->num_antennas > 0) printf(" and ");
+    return i;
+}
+
+bool parse_subcommand_args(const char* subcommand, int argc, char* argv[]) {
+    subcommand_args.pareto = false;
+    subcommand_args.min_coverage = 1;
+    subcommand_args.disk_sides = DEFAULT_DISK_SIDES;
+    subcommand_args.max_nodes = 0;
+    subcommand_args.threads = 0;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(subcommand, "optimize") == 0 && strcmp(argv[i], "--pareto") == 0) {
+            subcommand_args.pareto = true;
+        } else if (strcmp(subcommand, "coverage") == 0 && strcmp(argv[i], "--min") == 0) {
+            if (i + 1 >= argc) {
+                print_error_option_argument(argv[i]);
+                return false;
+            }
+            if (!is_valid_positive_integer(argv[i + 1]) || strlen(argv[i + 1]) > 9) {
+                print_error_argument_value(argv[i], argv[i + 1]);
+                return false;
+            }
+            subcommand_args.min_coverage = atoi(argv[++i]);
+        } else if (strcmp(subcommand, "hull") == 0 && strcmp(argv[i], "--sides") == 0) {
+            if (i + 1 >= argc) {
+                print_error_option_argument(argv[i]);
+                return false;
+            }
+            if (!is_valid_positive_integer(argv[i + 1]) || strlen(argv[i + 1]) > 9 ||
+                atoi(argv[i + 1]) < MIN_DISK_SIDES || atoi(argv[i + 1]) > MAX_DISK_SIDES) {
+                print_error_argument_value(argv[i], argv[i + 1]);
+                return false;
+            }
+            subcommand_args.disk_sides = atoi(argv[++i]);
+        } else if (strcmp(subcommand, "cover") == 0 && strcmp(argv[i], "--max-nodes") == 0) {
+            if (i + 1 >= argc) {
+                print_error_option_argument(argv[i]);
+                return false;
+            }
+            if (!is_valid_positive_integer(argv[i + 1]) || strlen(argv[i + 1]) > 9) {
+                print_error_argument_value(argv[i], argv[i + 1]);
+                return false;
+            }
+            subcommand_args.max_nodes = atoi(argv[++i]);
+        } else if (strcmp(subcommand, "optimize") == 0 && strcmp(argv[i], "--threads") == 0) {
+            if (i + 1 >= argc) {
+                print_error_option_argument(argv[i]);
+                return false;
+            }
+            if (!is_valid_positive_integer(argv[i + 1]) || strlen(argv[i + 1]) > 9 ||
+                atoi(argv[i + 1]) < 1 || atoi(argv[i + 1]) > PARETO_MAX_THREADS) {
+                print_error_argument_value(argv[i], argv[i + 1]);
+                return false;
+            }
+            subcommand_args.threads = atoi(argv[++i]);
+        } else {
+            print_error_subcommand_argument(subcommand, argv[i]);
+            return false;
+        }
     }
-    
-    if (scene->num_antennas > 0) {
-        printf("%d antenna%s", scene->num_antennas, scene->num_antennas > 1 ? "s" : "");
+    if (strcmp(subcommand, "optimize") == 0 && !subcommand_args.pareto) {
+        print_error_optimize_mode();
+        return false;
     }
-    printf("\n");
+    return true;
 }
 
-void print_building(const Building* b) {
-    printf("  building %s at %d %d with dimensions %d %d\n", 
-           b->id, b->x, b->y, b->w, b->h);
+// --------------------------------------------------------
+// SECTION: TRACE FUNCTIONS
+// --------------------------------------------------------
+
+bool trace_start(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+    fputs(TRACE_HEADER TRACE_TRAILER, file);
+    if (fclose(file) != 0) return false;
+
+    trace.path = path;
+    trace.events = NULL;
+    trace.num_events = 0;
+    trace.written = 0;
+    trace.capacity = 0;
+    trace.start = now_seconds();
+    return true;
 }
 
-void print_antenna(const Antenna* a) {
-    printf("  antenna %s at %d %d with range %d\n", 
-           a->id, a->x, a->y, a->r);
+void trace_event(const char* name, char phase) {
+    if (!trace.path) return;
+
+    pthread_mutex_lock(&trace_lock);
+    if (trace.num_events == trace.capacity) {
+        unsigned int new_capacity = trace.capacity ? trace.capacity * 2 : INITIAL_CAPACITY;
+        TraceEvent* new_events = kover_realloc(trace.events, trace.capacity * sizeof(TraceEvent),
+                                               new_capacity * sizeof(TraceEvent), MEM_TRACE);
+        if (!new_events) {
+            pthread_mutex_unlock(&trace_lock);
+            return;
+        }
+        trace.events = new_events;
+        trace.capacity = new_capacity;
+    }
+
+    TraceEvent* event = &trace.events[trace.num_events++];
+    event->name = name;
+    event->phase = phase;
+    event->timestamp = (now_seconds() - trace.start) * 1e6;
+    event->tid = trace_tid;
+    pthread_mutex_unlock(&trace_lock);
 }
 
-int compare_ids(const void* a, const void* b) {
-    return strcmp(*(const char**)a, *(const char**)b);
+bool trace_write() {
+    // New events overwrite the trailer, written again after them
+    FILE* file = fopen(trace.path, "r+");
+    if (!file || fseek(file, -(long)strlen(TRACE_TRAILER), SEEK_END) != 0) {
+        if (file) fclose(file);
+        print_error_file(trace.path);
+        return false;
+    }
+
+    for (unsigned int i = 0; i < trace.num_events; i++) {
+        const TraceEvent* event = &trace.events[i];
+        fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}",
+                trace.written + i > 0 ? "," : "", event->name, event->phase, event->timestamp,
+                TRACE_PID, event->tid);
+    }
+    fputs(TRACE_TRAILER, file);
+    trace.written += trace.num_events;
+    trace.num_events = 0;
+    if (fclose(file) != 0) {
+        print_error_file(trace.path);
+        return false;
+    }
+    return true;
 }
 
-void print_description(const Scene* scene) {
-    print_summary(scene);
-    print_sorted_buildings(scene);
-    print_sorted_antennas(scene);
+void trace_free() {
+    kover_free(trace.events, trace.capacity * sizeof(TraceEvent), MEM_TRACE);
+    trace.events = NULL;
+    trace.num_events = 0;
+    trace.written = 0;
+    trace.capacity = 0;
+    trace.path = NULL;
 }
 
 // --------------------------------------------------------
 // SECTION: MAIN FUNCTION
 // --------------------------------------------------------
 
+// Tools including this file (benchmarks) provide their own main
+#ifndef KOVER_NO_MAIN
+
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    Options options;
+    int first = parse_options(argc, argv, &options);
+    if (first < 0) return ERROR;
+    argc -= first - 1;
+    argv += first - 1;
+    memory.budget = options.max_memory;
+    rules.min_antenna_spacing = options.min_antenna_spacing;
+    rules.spacing_level = 0;
+    while ((1LL << rules.spacing_level) < rules.min_antenna_spacing) rules.spacing_level++;
+    
+    if (argc >= 2 && strcmp(argv[1], "watch") == 0) {
+        if (argc < 4) {
+            print_error_watch_usage();
+            return ERROR;
+        }
+        if (!is_scene_subcommand(argv[2])) {
+            print_error_unrecognized(argv[2]);
+            return ERROR;
+        }
+        if (!parse_subcommand_args(argv[2], argc - 4, argv + 3)) return ERROR;
+        if (options.trace_path && !trace_start(options.trace_path)) {
+            print_error_file(options.trace_path);
+            return ERROR;
+        }
+        return watch_file(argv[2], argv[argc - 1], &options);
+    }
+    
+    if (argc < 2) {
         print_error_mandatory();
         return ERROR;
     }
     
     const char* subcommand = argv[1];
     
-    if (strcmp(subcommand, "help") == 0) {
-        print_help();
-        return SUCCESS;
-    }
-    
     if (!is_valid_subcommand(subcommand)) {
         print_error_unrecognized(subcommand);
         return ERROR;
     }
     
-    Scene scene;
-    init_scene(&scene);
+    if (!parse_subcommand_args(subcommand, argc - 2, argv + 2)) return ERROR;
     
-    if (!read_scene(&scene)) {
-        return ERROR;
+    if (strcmp(subcommand, "help") == 0) {
+        print_help();
+        return SUCCESS;
     }
     
-    if (strcmp(subcommand, "bounding-box") == 0) {
-        print_bounding_box(&scene);
-    }
-    else if (strcmp(subcommand, "describe") == 0) {
-        print_description(&scene);
-    }
-    else if (strcmp(subcommand, "summarize") == 0) {
-        print_summary(&scene);
+    // The trace file is only created once the arguments are known to be valid
+    if (options.trace_path && !trace_start(options.trace_path)) {
+        print_error_file(options.trace_path);
+        return ERROR;
     }
     
-    return SUCCESS;
-}
\ No newline at end of file
+    int status = process_stream(subcommand, stdin, stdout, options.jobs);
+    if (options.stats) print_stats(stderr);
+    if (options.trace_path && !trace_write()) status = ERROR;
+    trace_free();
+    return status;
+}
+
+#endif
@@ -0,0 +1,58 @@
+#!/bin/bash
+#
+# Differential test of the indexed engine against the reference engine.
+#
+# Usage: tools/difftest.sh FAST_BINARY REFERENCE_BINARY [RUNS]
+#
+# Feeds random scenes generated by tools/gen_scene.awk to both binaries for
+# every scene subcommand and fails at the first difference of stdout, stderr
+# or exit code, leaving the offending scene in the temporary directory. Each
+# scene is also described under a few --min-antenna-spacing values so that the
+# indexed spacing rule is checked against the reference linear scan.
+
+fast="$1"
+reference="$2"
+runs="${3:-500}"
+subcommands="bounding-box describe summarize"
+spacings="3 50 1000 100000"
+
+if [ -z "$fast" ] || [ -z "$reference" ]; then
+    echo "usage: $0 FAST_BINARY REFERENCE_BINARY [RUNS]" >&2
+    exit 1
+fi
+
+tmp=$(mktemp -d)
+dir=$(dirname "$0")
+
+for seed in $(seq 1 "$runs"); do
+    awk -v seed="$seed" -f "$dir/gen_scene.awk" > "$tmp/scene"
+    runs_of_seed=$subcommands
+    for spacing in $spacings; do
+        runs_of_seed="$runs_of_seed --min-antenna-spacing=$spacing:describe"
+    done
+    for run in $runs_of_seed; do
+        # A run is either a subcommand or OPTION=VALUE:SUBCOMMAND
+        options=()
+        subcommand="${run##*:}"
+        if [ "$subcommand" != "$run" ]; then
+            option="${run%%:*}"
+            options=("${option%%=*}" "${option#*=}")
+        fi
+        "$fast" "${options[@]}" "$subcommand" < "$tmp/scene" > "$tmp/fast.out" 2> "$tmp/fast.err"
+        echo $? >> "$tmp/fast.out"
+        "$reference" "${options[@]}" "$subcommand" < "$tmp/scene" \
+            > "$tmp/reference.out" 2> "$tmp/reference.err"
+        echo $? >> "$tmp/reference.out"
+        if ! cmp -s "$tmp/fast.out" "$tmp/reference.out" ||
+           ! cmp -s "$tmp/fast.err" "$tmp/reference.err"; then
+            echo "difference on seed $seed with ${options[*]} $subcommand," \
+                 "scene kept in $tmp/scene" >&2
+            diff "$tmp/reference.out" "$tmp/fast.out" >&2
+            diff "$tmp/reference.err" "$tmp/fast.err" >&2
+            exit 1
+        fi
+    done
+done
+
+echo "$runs scenes identical for $subcommands and spacings $spacings"
+rm -rf "$tmp"
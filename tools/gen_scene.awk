@@ -0,0 +1,73 @@
+#!/usr/bin/awk -f
+#
+# Generates a random stream of scenes for the differential tests.
+#
+# Usage: awk -v seed=N -f tools/gen_scene.awk
+#
+# Most lines are valid; with a small probability a line is corrupted (bad
+# identifier, bad number, wrong argument count, unknown keyword) so that the
+# error paths are exercised as well. Some streams also reuse identifiers and
+# small extents provoke overlaps and shared positions.
+
+function rand_int(lo, hi) {
+    return lo + int(rand() * (hi - lo + 1))
+}
+
+function pick_id(prefix, i, n) {
+    r = rand()
+    if (r < corruption / 3) return "9" prefix
+    if (r < corruption * 2 / 3) return prefix "-" i
+    if (r < collisions) return prefix rand_int(0, n)
+    return prefix i
+}
+
+function pick_number(lo, hi) {
+    r = rand()
+    if (r < corruption / 3) return "0" rand_int(1, 9)
+    if (r < corruption * 2 / 3) return rand_int(lo, hi) "x"
+    return rand_int(lo, hi)
+}
+
+function indent() {
+    return rand() < 0.5 ? "  " : (rand() < 0.5 ? "\t" : "")
+}
+
+function building_line(i, n, span) {
+    size = span / (2 * n + 2) < 1 ? 1 : int(span / (2 * n + 2))
+    line = indent() "building " pick_id("b", i, n) " " pick_number(-span, span) " " \
+           pick_number(-span, span) " " pick_number(1, size) " " pick_number(1, size)
+    if (rand() < corruption / 4) line = line " 1"
+    return line
+}
+
+function antenna_line(i, n, span) {
+    line = indent() "antenna " pick_id("a", i, n) " " pick_number(-span, span) " " \
+           pick_number(-span, span) " " pick_number(1, span)
+    if (rand() < 0.3) line = line " " pick_number(0, 359) " " pick_number(1, 360)
+    if (rand() < corruption / 4) line = line " 1"
+    return line
+}
+
+function scene(span) {
+    n = rand_int(0, 60)
+    print (rand() < corruption / 4 ? "begin scenes" : "begin scene")
+    for (i = 0; i < n; i++) {
+        r = rand()
+        if (r < corruption / 8) print "  tower t" i " 0 0"
+        else if (r < 0.5) print building_line(i, n, span)
+        else print antenna_line(i, n, span)
+    }
+    if (rand() >= corruption / 8) print "end scene"
+}
+
+BEGIN {
+    srand(seed)
+    corruption = rand() < 0.5 ? 0 : 0.02
+    collisions = rand() < 0.5 ? 0 : 0.02
+    split("5 20 100 1000 1000000", spans, " ")
+    scenes = rand_int(1, 3)
+    for (s = 0; s < scenes; s++) {
+        if (s > 0 && rand() < 0.5) print ""
+        scene(spans[rand_int(1, 5)])
+    }
+}